@@ -0,0 +1,123 @@
+// BlockRegistry.cpp
+#include "BlockRegistry.h"
+#include <new>
+#include <stdexcept>
+
+BlockRegistry& BlockRegistry::Global() {
+    static BlockRegistry registry;
+    return registry;
+}
+
+BlockRegistry::~BlockRegistry() {
+    int count = nextId.load(std::memory_order_acquire);
+    for (size_t s = 0; s < kMaxSegments; ++s) {
+        Entry* segment = segments[s].load(std::memory_order_acquire);
+        if (!segment) continue;
+        size_t begin = s * kSegmentSize;
+        for (size_t i = 0; i < kSegmentSize && begin + i < static_cast<size_t>(count); ++i) {
+            segment[i].~Entry();
+        }
+        ::operator delete(segment, std::align_val_t(alignof(Entry)));
+        delete[] flagSegments[s].load(std::memory_order_acquire);
+    }
+}
+
+BlockRegistry::Entry* BlockRegistry::Slot(int id) {
+    size_t segmentIndex = static_cast<size_t>(id) >> kSegmentBits;
+    if (segmentIndex >= kMaxSegments) {
+        throw std::length_error("BlockRegistry: too many block states");
+    }
+    Entry* segment = segments[segmentIndex].load(std::memory_order_acquire);
+    if (!segment) {
+        std::lock_guard<std::mutex> lock(segmentMutex);
+        segment = segments[segmentIndex].load(std::memory_order_relaxed);
+        if (!segment) {
+            flagSegments[segmentIndex].store(new uint8_t[kSegmentSize](), std::memory_order_release);
+            segment = static_cast<Entry*>(::operator new(kSegmentSize * sizeof(Entry), std::align_val_t(alignof(Entry))));
+            segments[segmentIndex].store(segment, std::memory_order_release);
+        }
+    }
+    return segment + (static_cast<size_t>(id) & (kSegmentSize - 1));
+}
+
+int BlockRegistry::Intern(std::string_view name, bool* isNew) {
+    Shard& shard = shards[NameHash{}(name) % kShardCount];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.ids.find(name);
+    if (it != shard.ids.end()) {
+        if (isNew) *isNew = false;
+        return it->second;
+    }
+
+    // 先构造方块再登记名称,其他线程只能在分片锁之后看到这个ID
+    int id = nextId.fetch_add(1, std::memory_order_acq_rel);
+    std::string key(name);
+    Block block(key);
+    BlockTraits traits = MakeTraits(block);
+    uint8_t flags = traits.flags;
+    new (Slot(id)) Entry{ std::move(block), std::move(traits) };
+    flagSegments[static_cast<size_t>(id) >> kSegmentBits].load(std::memory_order_relaxed)[static_cast<size_t>(id) & (kSegmentSize - 1)] = flags;
+    shard.ids.emplace(std::move(key), id);
+    if (isNew) *isNew = true;
+    return id;
+}
+
+const BlockRegistry::Entry* BlockRegistry::Find(int id) const {
+    if (id < 0 || id >= nextId.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    Entry* segment = segments[static_cast<size_t>(id) >> kSegmentBits].load(std::memory_order_acquire);
+    return segment ? segment + (static_cast<size_t>(id) & (kSegmentSize - 1)) : nullptr;
+}
+
+const Block* BlockRegistry::Get(int id) const {
+    const Entry* entry = Find(id);
+    return entry ? &entry->block : nullptr;
+}
+
+const BlockTraits* BlockRegistry::GetTraits(int id) const {
+    const Entry* entry = Find(id);
+    return entry ? &entry->traits : nullptr;
+}
+
+// 一次性解析方块名中网格生成需要的所有部分
+BlockTraits BlockRegistry::MakeTraits(const Block& block) {
+    BlockTraits traits;
+    traits.namespaceName = block.GetNamespace();
+    traits.nameWithoutState = block.GetNameAndNameSpaceWithoutState();
+    traits.modifiedName = block.GetModifiedName();
+    traits.modifiedNameWithNamespace = block.GetModifiedNameWithNamespace();
+    traits.level = block.level;
+    traits.air = block.air;
+    traits.isAirBlock = (block.name == "minecraft:air");
+    traits.isFluid = fluidDefinitions.find(traits.nameWithoutState) != fluidDefinitions.end();
+
+    std::string_view baseName(traits.nameWithoutState);
+    size_t colonPos = baseName.find(':');
+    if (colonPos != std::string_view::npos) {
+        baseName = baseName.substr(colonPos + 1);
+    }
+    traits.isLightBlock = (baseName == "light");
+
+    traits.flags = static_cast<uint8_t>((traits.air ? 0 : BLOCK_FLAG_OPAQUE)
+        | (traits.isFluid ? BLOCK_FLAG_FLUID : 0)
+        | (traits.level != -1 ? BLOCK_FLAG_HAS_FLUID : 0)
+        | (traits.level == 0 ? BLOCK_FLAG_WATERLOGGED : 0)
+        | (traits.isAirBlock ? BLOCK_FLAG_AIR_BLOCK : 0));
+
+    std::lock_guard<std::mutex> lock(baseNameMutex);
+    traits.baseId = baseIds.try_emplace(traits.nameWithoutState, static_cast<int>(baseIds.size())).first->second;
+    return traits;
+}
+
+std::vector<Block> BlockRegistry::Snapshot() const {
+    std::vector<Block> blocks;
+    size_t count = Size();
+    blocks.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (const Block* block = Get(static_cast<int>(i))) {
+            blocks.push_back(*block);
+        }
+    }
+    return blocks;
+}
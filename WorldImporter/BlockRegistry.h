@@ -0,0 +1,89 @@
+// BlockRegistry.h
+#ifndef BLOCK_REGISTRY_H
+#define BLOCK_REGISTRY_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "block.h"
+
+// 全局方块状态注册表:把方块状态字符串("name[key:value,...]")映射为稳定的整数ID
+// 子区块调色板与实体方块共用同一个映射,同一字符串在整个导出过程中只有一个ID
+//
+// 每个ID同时保存 Block 与注册时预先计算的 BlockTraits
+// 存储按固定大小分段,分段一经分配就不再移动,因此 Get 无需加锁;
+// 注册按字符串哈希分片加锁,不同分片的注册互不阻塞
+class BlockRegistry {
+public:
+    static BlockRegistry& Global();
+
+    BlockRegistry() = default;
+    ~BlockRegistry();
+
+    BlockRegistry(const BlockRegistry&) = delete;
+    BlockRegistry& operator=(const BlockRegistry&) = delete;
+
+    // 返回方块状态对应的ID,不存在时注册;isNew 不为空时写入本次调用是否新注册
+    int Intern(std::string_view name, bool* isNew = nullptr);
+
+    // 按ID读取方块(无锁),ID 无效时返回 nullptr
+    // 只能读取已由 Intern 返回过的ID
+    const Block* Get(int id) const;
+    const BlockTraits* GetTraits(int id) const;
+
+    // 按ID读取属性位(无锁,一次分段查找),ID 无效时返回空气的属性位
+    uint8_t Flags(int id) const {
+        if (id < 0 || id >= nextId.load(std::memory_order_acquire)) return static_cast<uint8_t>(BLOCK_FLAG_AIR_BLOCK);
+        const uint8_t* segment = flagSegments[static_cast<size_t>(id) >> kSegmentBits].load(std::memory_order_acquire);
+        return segment ? segment[static_cast<size_t>(id) & (kSegmentSize - 1)] : static_cast<uint8_t>(BLOCK_FLAG_AIR_BLOCK);
+    }
+
+    // 已分配的ID数量
+    size_t Size() const { return static_cast<size_t>(nextId.load(std::memory_order_acquire)); }
+
+    // 复制当前所有方块(仅在没有并发注册时调用)
+    std::vector<Block> Snapshot() const;
+
+private:
+    static constexpr size_t kSegmentBits = 10;
+    static constexpr size_t kSegmentSize = size_t(1) << kSegmentBits;
+    static constexpr size_t kMaxSegments = 4096;
+    static constexpr size_t kShardCount = 16;
+
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const noexcept { return std::hash<std::string_view>{}(name); }
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, int, NameHash, std::equal_to<>> ids;
+    };
+
+    struct Entry {
+        Block block;
+        BlockTraits traits;
+    };
+
+    // 返回 ID 对应的存储位置,所在分段不存在时分配
+    Entry* Slot(int id);
+    const Entry* Find(int id) const;
+    BlockTraits MakeTraits(const Block& block);
+
+    std::array<Shard, kShardCount> shards;
+    std::array<std::atomic<Entry*>, kMaxSegments> segments{};
+    std::array<std::atomic<uint8_t*>, kMaxSegments> flagSegments{}; // 与 segments 同步分配的紧凑属性位数组
+    std::atomic<int> nextId{ 0 };
+    std::mutex segmentMutex;
+
+    // 不带状态的方块名编号(BlockTraits::baseId),只在注册新方块时访问
+    std::mutex baseNameMutex;
+    std::unordered_map<std::string, int> baseIds;
+};
+
+#endif // BLOCK_REGISTRY_H
@@ -9,8 +9,6 @@ class ChunkGenerator {
 public:
     static ModelData GenerateChunkModel(int chunkX, int sectionY, int chunkZ);
     static ModelData GenerateLODChunkModel(int chunkX, int sectionY, int chunkZ, float lodSize);
-private:
-    static void ProcessBlockForModel(ModelData& chunkModel, int x, int y, int z);
 };
 
 #endif // CHUNK_GENERATOR_H
\ No newline at end of file
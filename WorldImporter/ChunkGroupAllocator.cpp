@@ -1,6 +1,7 @@
 // chunk_group_allocator.cpp
 #include "ChunkGroupAllocator.h"
 #include "LODManager.h" // 包含LODManager.h以访问g_chunkLODs
+#include "RegionCache.h"
 #include <iostream> // 用于潜在的调试输出
 #include <limits> // 新增:用于 numeric_limits
 #include <algorithm>
@@ -40,6 +41,10 @@ namespace ChunkGroupAllocator {
 
                 for (int chunkX = groupX; chunkX <= currentGroupXEnd; ++chunkX) {
                     for (int chunkZ = groupZ; chunkZ <= currentGroupZEnd; ++chunkZ) {
+                        // 存档中不存在的区块不生成任务
+                        if (!HasChunk(chunkX, chunkZ)) {
+                            continue;
+                        }
                         for (int sectionY = sectionYStart; sectionY <= sectionYEnd; ++sectionY) {
                             ChunkTask task;
                             task.chunkX = chunkX;
@@ -63,7 +68,9 @@ namespace ChunkGroupAllocator {
                     }
                 }
 
-                g_chunkGroups.push_back(newGroup);
+                if (!newGroup.tasks.empty()) {
+                    g_chunkGroups.push_back(newGroup);
+                }
             }
         }
     }
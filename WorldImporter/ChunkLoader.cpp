@@ -3,87 +3,147 @@
 #include <thread>
 #include <vector>
 #include <shared_mutex>
+#include <algorithm>
+#include "ThreadPool.h"
 #include "locutil.h"
 #include "ChunkLoader.h"
 #include "block.h"
 #include "LODManager.h"
 #include "RegionCache.h"
 
-void ChunkLoader::LoadChunks(int chunkXStart, int chunkXEnd, int chunkZStart, int chunkZEnd,
-    int sectionYStart, int sectionYEnd) {
-
-    // 使用多线程加载所有相关的分块和分段
-    std::vector<std::future<void>> futures;
+// 单个 region 内待加载的区块,按扇区偏移升序排列
+struct RegionLoadList {
+    int regionX;
+    int regionZ;
+    std::vector<std::tuple<uint32_t, int, int>> chunks; // (扇区偏移, chunkX, chunkZ)
+};
 
+// 按 region 分组范围内存在的区块,并按扇区偏移排序,使加载时按文件顺序读取
+static std::vector<RegionLoadList> BuildSectorOrderedLoadLists(int chunkXStart, int chunkXEnd, int chunkZStart, int chunkZEnd) {
+    std::unordered_map<std::pair<int, int>, size_t, pair_hash> listIndex;
+    std::vector<RegionLoadList> lists;
     for (int chunkX = chunkXStart; chunkX <= chunkXEnd; ++chunkX) {
         for (int chunkZ = chunkZStart; chunkZ <= chunkZEnd; ++chunkZ) {
-            // 新增:如果 chunk 不存在于 region 文件中或为空，则跳过加载
-            if (!HasChunk(chunkX, chunkZ)) {
+            int regionX, regionZ;
+            chunkToRegion(chunkX, chunkZ, regionX, regionZ);
+            const RegionHeader* header = GetRegionHeader(regionX, regionZ);
+            // 新增:如果 chunk 不存在于 region 文件中或为空，则跳过加载(查询文件头索引,不访问文件系统)
+            int localX = chunkX - regionX * 32;
+            int localZ = chunkZ - regionZ * 32;
+            if (!header || !header->HasChunk(localX, localZ)) {
                 continue;
             }
-            futures.push_back(std::async(std::launch::async, [&, chunkX, chunkZ]() {
-                LoadAndCacheBlockData(chunkX, chunkZ);
-                for (int sectionY = sectionYStart; sectionY <= sectionYEnd; ++sectionY) {
-                    auto key = std::make_tuple(chunkX, sectionY, chunkZ);
-                    // 确保条目存在（可能由RegionModelExporter预先创建以存储LOD）
-                    // 如果不存在，则创建一个新的条目并设置加载状态
-                    // LOD值在此处不设置，它由RegionModelExporter负责
-                    {
-                        std::unique_lock<std::shared_mutex> lock(g_chunkSectionInfoMapMutex);
-                        g_chunkSectionInfoMap[key].isLoaded.store(true, std::memory_order_release);
-                    }
-                }
-                }));
+            auto [it, inserted] = listIndex.try_emplace({ regionX, regionZ }, lists.size());
+            if (inserted) {
+                lists.push_back({ regionX, regionZ, {} });
+            }
+            lists[it->second].chunks.emplace_back(header->sectorOffsets[localX + localZ * 32], chunkX, chunkZ);
         }
     }
+    for (auto& list : lists) {
+        std::sort(list.chunks.begin(), list.chunks.end());
+    }
+    return lists;
+}
 
-    // 等待所有线程完成
-    for (auto& future : futures) {
-        future.get();
+// 加载单个区块并标记其分段为已加载
+static void LoadChunk(int chunkX, int chunkZ, int sectionYStart, int sectionYEnd) {
+    LoadAndCacheBlockData(chunkX, chunkZ);
+    for (int sectionY = sectionYStart; sectionY <= sectionYEnd; ++sectionY) {
+        auto key = std::make_tuple(chunkX, sectionY, chunkZ);
+        // 确保条目存在（可能由RegionModelExporter预先创建以存储LOD）
+        // 如果不存在，则创建一个新的条目并设置加载状态
+        // LOD值在此处不设置，它由RegionModelExporter负责
+        {
+            std::unique_lock<std::shared_mutex> lock(g_chunkSectionInfoMapMutex);
+            g_chunkSectionInfoMap[key].isLoaded.store(true, std::memory_order_release);
+        }
     }
 }
 
+// 单个 region 内一段连续(按扇区顺序)的区块,作为一个线程池任务
+struct RegionLoadRun {
+    const RegionLoadList* list;
+    size_t begin;
+    size_t end;
+};
+
+void ChunkLoader::LoadChunks(int chunkXStart, int chunkXEnd, int chunkZStart, int chunkZEnd,
+    int sectionYStart, int sectionYEnd) {
+
+    std::vector<RegionLoadList> lists = BuildSectorOrderedLoadLists(chunkXStart, chunkXEnd, chunkZStart, chunkZEnd);
+
+    // 把每个 region 的有序区块切分为若干连续段,段不跨 region,段内按扇区偏移升序读取
+    ThreadPool& pool = ThreadPool::Loader();
+    size_t totalChunks = 0;
+    for (const auto& list : lists) totalChunks += list.chunks.size();
+    const size_t runSize = std::max<size_t>(16, (totalChunks + pool.Size() * 4 - 1) / (pool.Size() * 4));
+    std::vector<RegionLoadRun> runs;
+    for (const auto& list : lists) {
+        for (size_t begin = 0; begin < list.chunks.size(); begin += runSize) {
+            runs.push_back({ &list, begin, std::min(begin + runSize, list.chunks.size()) });
+        }
+    }
+
+    pool.ParallelFor(runs.size(), [&](size_t runIndex) {
+        const RegionLoadRun& run = runs[runIndex];
+        const RegionLoadList& list = *run.list;
+        if (config.useReadaheadHint) {
+            const RegionHeader* header = GetRegionHeader(list.regionX, list.regionZ);
+            RegionFilePtr region = GetRegionFromCache(list.regionX, list.regionZ);
+            if (header && region) {
+                // 预读本段第一个到最后一个区块覆盖的文件范围
+                const auto& last = list.chunks[run.end - 1];
+                int lastLocal = (std::get<1>(last) - list.regionX * 32) + (std::get<2>(last) - list.regionZ * 32) * 32;
+                uint64_t begin = static_cast<uint64_t>(std::get<0>(list.chunks[run.begin])) * 4096;
+                uint64_t end = (static_cast<uint64_t>(std::get<0>(last)) + header->sectorCounts[lastLocal]) * 4096;
+                region->AdviseWillNeed(begin, end - begin);
+            }
+        }
+        for (size_t i = run.begin; i < run.end; ++i) {
+            const auto& [sectorOffset, chunkX, chunkZ] = list.chunks[i];
+            LoadChunk(chunkX, chunkZ, sectionYStart, sectionYEnd);
+        }
+    });
+}
+
 void ChunkLoader::UnloadChunks(int chunkXStart, int chunkXEnd, int chunkZStart, int chunkZEnd,
     int sectionYStart, int sectionYEnd,
     const std::unordered_set<std::pair<int, int>, pair_hash>& retain_expanded_chunks) {
-    // 卸载指定范围的区块和分段
-    std::vector<std::future<void>> futures;
-    for (int chunkX = chunkXStart; chunkX <= chunkXEnd; ++chunkX) {
+    // 卸载指定范围的区块和分段,每列区块(同一 chunkX)作为一个线程池任务
+    if (chunkXEnd < chunkXStart) return;
+    ThreadPool::Loader().ParallelFor(static_cast<size_t>(chunkXEnd - chunkXStart + 1), [&](size_t column) {
+        const int chunkX = chunkXStart + static_cast<int>(column);
         for (int chunkZ = chunkZStart; chunkZ <= chunkZEnd; ++chunkZ) {
-            futures.push_back(std::async(std::launch::async, [=, &retain_expanded_chunks]() {
-                // 如果区块在保留集合中，则跳过卸载
-                if (retain_expanded_chunks.count({chunkX, chunkZ})) {
-                    return;
-                }
+            // 如果区块在保留集合中，则跳过卸载
+            if (retain_expanded_chunks.count({chunkX, chunkZ})) {
+                continue;
+            }
 
-                // 清理 g_chunkSectionInfoMap (使用原始 sectionY)
-                for (int sectionY = sectionYStart; sectionY <= sectionYEnd; ++sectionY) {
-                    auto g_map_key = std::make_tuple(chunkX, sectionY, chunkZ);
-                    {
-                        std::unique_lock<std::shared_mutex> lock(g_chunkSectionInfoMapMutex);
-                        g_chunkSectionInfoMap.erase(g_map_key);
-                    }
+            // 清理 g_chunkSectionInfoMap (使用原始 sectionY)
+            for (int sectionY = sectionYStart; sectionY <= sectionYEnd; ++sectionY) {
+                auto g_map_key = std::make_tuple(chunkX, sectionY, chunkZ);
+                {
+                    std::unique_lock<std::shared_mutex> lock(g_chunkSectionInfoMapMutex);
+                    g_chunkSectionInfoMap.erase(g_map_key);
                 }
+            }
 
-                // 清理 sectionCache 中与该 (chunkX, chunkZ) 相关的所有条目
-                ClearSectionCacheForChunk(chunkX, chunkZ);
+            // 清理 sectionCache 中与该 (chunkX, chunkZ) 相关的所有条目
+            ClearSectionCacheForChunk(chunkX, chunkZ);
 
-                // 卸载与区块相关的实体方块及高度图缓存
-                // 确保这些操作在 sectionY 循环之外，并使用正确的互斥锁
-                {
-                    std::unique_lock<std::shared_mutex> lock(entityBlockCacheMutex); // 使用 entityBlockCacheMutex
-                    EntityBlockCache.erase(std::make_pair(chunkX, chunkZ));
-                }
-                {
-                    std::unique_lock<std::shared_mutex> lock(heightMapCacheMutex); // 使用 heightMapCacheMutex
-                    heightMapCache.erase(std::make_pair(chunkX, chunkZ));
-                }
-            }));
+            // 卸载与区块相关的实体方块及高度图缓存
+            // 确保这些操作在 sectionY 循环之外，并使用正确的互斥锁
+            {
+                std::unique_lock<std::shared_mutex> lock(entityBlockCacheMutex); // 使用 entityBlockCacheMutex
+                EntityBlockCache.erase(std::make_pair(chunkX, chunkZ));
+            }
+            {
+                std::unique_lock<std::shared_mutex> lock(heightMapCacheMutex); // 使用 heightMapCacheMutex
+                heightMapCache.erase(std::make_pair(chunkX, chunkZ));
+            }
         }
-    }
-    for (auto& f : futures) {
-        f.get();
-    }
+    });
 }
 
 void ChunkLoader::CalculateChunkLODs(int expandedChunkXStart, int expandedChunkXEnd, int expandedChunkZStart, int expandedChunkZEnd,
@@ -48,12 +48,10 @@ ModelData YuushyaShowBlockEntity::GenerateModel() const {
 
         if (!block.isShown) continue;
 
-        Block b = GetBlockById(id);
-        std::string blockName = b.GetModifiedNameWithNamespace();
-        std::string ns = b.GetNamespace();
+        const BlockTraits& traits = GetBlockTraits(id);
+        const std::string& blockName = traits.modifiedName;
+        const std::string& ns = traits.namespaceName;
         // 获取模型数据
-        size_t colonPos = blockName.find(':');
-        if (colonPos != std::string::npos) blockName = blockName.substr(colonPos + 1);
         ModelData blockModel = GetRandomModelFromCache(ns, blockName);
 
         // 如果缓存未命中,尝试处理 blockstate 并重新获取模型
@@ -86,19 +86,14 @@ std::string getExecutablePathForTexture() {
     }
 }
 
-std::string GetBlockAverageColor(int blockId, Block currentBlock, int x, int y, int z, const std::string& faceDirection, float gamma = 2.0) {
+std::string GetBlockAverageColor(int blockId, const Block& currentBlock, int x, int y, int z, const std::string& faceDirection, float gamma = 2.0) {
 
-    Block b = GetBlockById(blockId);
-    std::string blockName = b.GetModifiedNameWithNamespace();
-    std::string ns = b.GetNamespace();
+    const BlockTraits& traits = GetBlockTraits(blockId);
+    const std::string& blockName = traits.modifiedName;
+    const std::string& ns = traits.namespaceName;
 
-    size_t colonPos = blockName.find(':');
-    if (colonPos != std::string::npos) {
-        blockName = blockName.substr(colonPos + 1);
-    }
     ModelData blockModel;
-    bool isFluid = (fluidDefinitions.find(currentBlock.GetNameAndNameSpaceWithoutState()) != fluidDefinitions.end());
-    if (isFluid && currentBlock.level > -1) {
+    if (traits.isFluid && currentBlock.level > -1) {
         AssignFluidMaterials(blockModel, currentBlock.name);
     }
     else {
@@ -234,7 +229,7 @@ std::string GetBlockAverageColor(int blockId, Block currentBlock, int x, int y,
         // 根据配置的小数位数格式化最终颜色字符串
         std::ostringstream oss;
         oss << std::fixed << std::setprecision(config.decimalPlaces);
-        if (isFluid) {
+        if (traits.isFluid) {
             oss << "color#" << finalR << " " << finalG << " " << finalB << "-" << currentBlock.GetNameAndNameSpaceWithoutState().c_str();
         }
         else {
@@ -243,7 +238,7 @@ std::string GetBlockAverageColor(int blockId, Block currentBlock, int x, int y,
         return oss.str();
     }
     else {
-        if (isFluid) {
+        if (traits.isFluid) {
             return  + "color#" + textureAverage + "-" + currentBlock.GetNameAndNameSpaceWithoutState();
         }
         else {
@@ -266,9 +261,9 @@ float LODManager::GetChunkLODAtBlock(int x, int y, int z) {
 
 BlockType GetBlockType(int x, int y, int z) {
     int currentId = GetBlockId(x, y, z);
-    Block currentBlock = GetBlockById(currentId);
+    const BlockTraits& currentBlock = GetBlockTraits(currentId);
 
-    if (currentBlock.name == "minecraft:air") {
+    if (currentBlock.isAirBlock) {
         return AIR;
     }
     else if (currentBlock.level > -1) {
@@ -281,7 +276,7 @@ BlockType GetBlockType(int x, int y, int z) {
 
 BlockType GetBlockType2(int x, int y, int z) {
     int currentId = GetBlockId(x, y, z);
-    Block currentBlock = GetBlockById(currentId);
+    const BlockTraits& currentBlock = GetBlockTraits(currentId);
 
     if (!currentBlock.air && currentBlock.level == -1) {
         return SOLID;
@@ -406,7 +401,7 @@ BlockType LODManager::DetermineLODBlockTypeWithUpperCheck(int x, int y, int z, i
 }
 
 std::vector<std::string> LODManager::GetBlockColor(int x, int y, int z, int id, BlockType blockType) {
-    Block currentBlock = GetBlockById(id);
+    const Block& currentBlock = GetBlockById(id);
 
     if (blockType == FLUID) {
         return {GetBlockAverageColor(id, currentBlock, x, y, z, "none") };
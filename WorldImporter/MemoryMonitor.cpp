@@ -5,6 +5,7 @@
 #include <chrono>
 #include <atomic>
 #include <numeric> // For std::accumulate
+#include <unordered_set>
 
 // 辅助函数，估算 vector<T> 的深层内存占用
 template <typename T>
@@ -74,11 +75,25 @@ size_t estimate_vector_memory(const std::vector<T>& vec) {
 // 辅助函数，估算 SectionCacheEntry 的深层内存占用
 size_t estimate_section_cache_entry_memory(const SectionCacheEntry& entry) {
     size_t memory = sizeof(SectionCacheEntry);
-    memory += estimate_vector_memory(entry.skyLight);
-    memory += estimate_vector_memory(entry.blockLight);
-    memory += estimate_vector_memory(entry.blockData);
-    memory += estimate_vector_memory(entry.biomeData);
-    memory += estimate_vector_memory(entry.blockPalette); // vector<string>
+    memory += estimate_vector_memory(entry.blockIndices);
+    memory += estimate_vector_memory(entry.wideBlockIndices);
+    memory += estimate_vector_memory(entry.blockPalette);
+    memory += estimate_vector_memory(entry.skyLight.data);
+    memory += estimate_vector_memory(entry.blockLight.data);
+    memory += estimate_vector_memory(entry.biomePalette);
+    memory += estimate_vector_memory(entry.opaqueRows);
+    return memory;
+}
+
+// 辅助函数，估算子区块缓存的深层内存占用(区块列指针数组 + 各子区块)
+size_t estimate_section_store_memory(const SectionStore& store) {
+    size_t memory = sizeof(SectionStore);
+    std::unordered_set<std::pair<int, int>, pair_hash> columns;
+    store.ForEach([&](int chunkX, int chunkZ, int, const SectionCacheEntry& entry) {
+        columns.emplace(chunkX, chunkZ);
+        memory += estimate_section_cache_entry_memory(entry);
+    });
+    memory += columns.size() * sizeof(SectionStore::Column);
     return memory;
 }
 
@@ -141,7 +156,7 @@ void MonitorTask(
 
         {
             std::shared_lock<std::shared_mutex> lock(*sectionCacheMutex);
-            section_cache_size_bytes = estimate_unordered_map_memory(*sectionCache);
+            section_cache_size_bytes = estimate_section_store_memory(*sectionCache);
         }
         {
             std::shared_lock<std::shared_mutex> lock(*entityBlockCacheMutex);
@@ -14,9 +14,10 @@
 // struct pair_hash; (在 hashutils.h 中定义, 被 block.h 包含)
 // struct triple_hash; (在 hashutils.h 中定义, 被 block.h 包含)
 #include "block.h" // 假设 block.h 提供了 SectionCacheEntry 等类型的定义
+#include "SectionStore.h"
 
 // 为缓存类型定义别名，以保持清晰，确保与 block.cpp 中的定义一致
-using SectionCacheType = std::unordered_map<std::tuple<int, int, int>, SectionCacheEntry, triple_hash>;
+using SectionCacheType = SectionStore;
 using EntityBlockCacheType = std::unordered_map<std::pair<int, int>, std::vector<std::shared_ptr<EntityBlock>>, pair_hash>;
 using HeightMapCacheType = std::unordered_map<std::pair<int, int>, std::unordered_map<std::string, std::vector<int>>, pair_hash>;
 
@@ -913,7 +913,7 @@ void ModelDeduplicator::GreedyMesh(ModelData& data) {
 }
 
 // 综合去重和优化方法
-void ModelDeduplicator::DeduplicateModel(ModelData& data) {
+void ModelDeduplicator::DeduplicateModel(ModelData& data, bool greedyMesh) {
     using Clock = std::chrono::high_resolution_clock;
     using Ms = std::chrono::duration<double, std::milli>;
     auto dm_start = Clock::now();
@@ -943,7 +943,7 @@ void ModelDeduplicator::DeduplicateModel(ModelData& data) {
         std::cerr << "DeduplicateFaces: " << Ms(t5 - t4).count() << " ms\n";
     }
 
-    if (config.useGreedyMesh) {
+    if (config.useGreedyMesh && greedyMesh) {
         monitor.SetStatus(TaskStatus::GREEDY_MESHING, "GreedyMesh");
         {
             auto tg0 = Clock::now();
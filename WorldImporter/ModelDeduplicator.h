@@ -20,7 +20,8 @@ public:
     static void GreedyMesh(ModelData& data);
 
     // 综合去重和优化方法
-    static void DeduplicateModel(ModelData& data);
+    // greedyMesh 为 false 时跳过 GreedyMesh(面已在网格生成时按体素合并)
+    static void DeduplicateModel(ModelData& data, bool greedyMesh = true);
 
 };
 
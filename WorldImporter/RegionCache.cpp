@@ -5,9 +5,62 @@
 #include <fstream>
 #include <filesystem> // 用于检测目录是否存在
 #include <cstdint> // 用于 uint8_t, uint32_t
+#include <cstring>
+#include <algorithm>
 #include <vector>
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include "locutil.h"
-std::unordered_map<std::pair<int, int>, std::vector<char>, pair_hash> regionCache(1024);
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// region 映射缓存:键为 region 坐标,只缓存成功打开的文件
+// 不存在的 region 不占用缓存项(稀疏存档上不会堆积空项),重复查询由文件头索引拦截,不会反复探测文件系统
+struct RegionCacheEntry {
+    RegionFilePtr file;
+    std::list<std::pair<int, int>>::iterator lruIt; // 在 LRU 链表中的位置(表头为最近使用)
+};
+
+static std::unordered_map<std::pair<int, int>, RegionCacheEntry, pair_hash> regionCache(1024);
+static std::list<std::pair<int, int>> regionLru;
+static size_t regionCacheBytes = 0;
+
+// 每个打开的文件句柄计入的名义开销:按区块读取模式的 Size() 为 0,不计入则 LRU 永远不会关闭它们
+// 默认 1024MB 预算下最多约 256 个句柄,低于常见的进程文件描述符上限
+static constexpr size_t kOpenFileCost = 4 * 1024 * 1024;
+
+// 缓存项计入预算的开销:映射大小加上句柄的名义开销
+static size_t RegionCacheCost(const RegionFile& file) {
+    return file.Size() + kOpenFileCost;
+}
+static std::mutex regionCacheMutex;
+
+// region 文件头索引
+// 索引范围内的文件头存于稠密数组(构建后只读,无锁查询),范围外的按需解析存于 regionHeaderExtra
+static std::string regionDirectory;
+static bool regionDirectoryResolved = false;
+static std::mutex regionDirectoryMutex;
+static std::unordered_set<std::pair<int, int>, pair_hash> presentRegions; // 目录中存在的 region 文件
+static bool presentRegionsScanned = false;
+static std::vector<std::unique_ptr<RegionHeader>> regionHeaderGrid;
+static std::vector<uint8_t> regionMapWholeGrid; // 该 region 是否整文件映射
+static int gridRegionXStart = 0, gridRegionZStart = 0, gridWidth = 0, gridDepth = 0;
+static std::unordered_map<std::pair<int, int>, std::unique_ptr<RegionHeader>, pair_hash> regionHeaderExtra;
+static std::shared_mutex regionHeaderExtraMutex;
 
 // 将维度ID(如 minecraft:overworld)拆分为命名空间和名称两部分
 static void SplitDimensionId(const std::string& sel, std::string& ns, std::string& name) {
@@ -92,67 +145,359 @@ static std::string GetRegionDirectory() {
     return base + "/region";
 }
 
-//读取.mca文件到内存
-std::vector<char> ReadFileToMemory(const std::string& regionDirPath, int regionX, int regionZ) {
-    // 构造区域文件的路径
+// 构造区域文件的路径
+static std::string BuildRegionFilePath(const std::string& regionDirPath, int regionX, int regionZ) {
     std::ostringstream filePathStream;
     filePathStream << regionDirPath << "/r." << regionX << "." << regionZ << ".mca";
-    std::string filePath = filePathStream.str();
+    return filePathStream.str();
+}
+
+// --------------------------------------------------------------------------------
+// region 文件头索引
+// --------------------------------------------------------------------------------
+const std::string& GetRegionDirectoryPath() {
+    std::lock_guard<std::mutex> lock(regionDirectoryMutex);
+    if (!regionDirectoryResolved) {
+        regionDirectory = GetRegionDirectory();
+        regionDirectoryResolved = true;
+    }
+    return regionDirectory;
+}
 
-    // 打开文件
+// 解析 r.<x>.<z>.mca 文件名,成功返回 true
+static bool ParseRegionFileName(const std::string& name, int& regionX, int& regionZ) {
+    if (name.size() < 9 || name.rfind("r.", 0) != 0 || name.compare(name.size() - 4, 4, ".mca") != 0) {
+        return false;
+    }
+    std::string coords = name.substr(2, name.size() - 6);
+    size_t dot = coords.find('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    try {
+        size_t usedX = 0, usedZ = 0;
+        std::string xs = coords.substr(0, dot);
+        std::string zs = coords.substr(dot + 1);
+        regionX = std::stoi(xs, &usedX);
+        regionZ = std::stoi(zs, &usedZ);
+        return usedX == xs.size() && usedZ == zs.size();
+    } catch (...) {
+        return false;
+    }
+}
+
+// 读取并解析 region 文件的前 8KB,文件不存在或过短时返回 nullptr
+static std::unique_ptr<RegionHeader> LoadRegionHeader(int regionX, int regionZ) {
+    if (presentRegionsScanned && !presentRegions.count({ regionX, regionZ })) {
+        return nullptr;
+    }
+    std::string filePath = BuildRegionFilePath(GetRegionDirectoryPath(), regionX, regionZ);
     std::ifstream file(filePath, std::ios::binary);
     if (!file) {
-        std::cerr << "错误: 打开文件失败!" << std::endl;
-        return {};  // 返回空vector表示失败
+        return nullptr;
+    }
+    uint8_t bytes[8192];
+    if (!file.read(reinterpret_cast<char*>(bytes), sizeof(bytes))) {
+        return nullptr;
+    }
+
+    auto header = std::make_unique<RegionHeader>();
+    for (int i = 0; i < 1024; ++i) {
+        const uint8_t* loc = bytes + i * 4;
+        const uint8_t* ts = bytes + 4096 + i * 4;
+        header->sectorOffsets[i] = ((uint32_t)loc[0] << 16) | ((uint32_t)loc[1] << 8) | (uint32_t)loc[2];
+        header->sectorCounts[i] = loc[3];
+        header->timestamps[i] = ((uint32_t)ts[0] << 24) | ((uint32_t)ts[1] << 16) | ((uint32_t)ts[2] << 8) | (uint32_t)ts[3];
+    }
+    return header;
+}
+
+void BuildRegionIndex(int chunkXStart, int chunkXEnd, int chunkZStart, int chunkZEnd) {
+    ClearRegionCache();
+    {
+        std::lock_guard<std::mutex> lock(regionDirectoryMutex);
+        regionDirectoryResolved = false;
+    }
+    const std::string& dir = GetRegionDirectoryPath();
+
+    // 一次目录扫描代替逐个 region 的 exists 探测
+    presentRegions.clear();
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        int regionX, regionZ;
+        if (entry.is_regular_file(ec) && ParseRegionFileName(entry.path().filename().string(), regionX, regionZ)) {
+            presentRegions.insert({ regionX, regionZ });
+        }
+    }
+    presentRegionsScanned = !ec;
+
+    int regionXEnd, regionZEnd;
+    chunkToRegion(chunkXStart, chunkZStart, gridRegionXStart, gridRegionZStart);
+    chunkToRegion(chunkXEnd, chunkZEnd, regionXEnd, regionZEnd);
+    gridWidth = regionXEnd - gridRegionXStart + 1;
+    gridDepth = regionZEnd - gridRegionZStart + 1;
+
+    regionHeaderGrid.clear();
+    regionHeaderGrid.resize(static_cast<size_t>(gridWidth) * gridDepth);
+    regionMapWholeGrid.assign(static_cast<size_t>(gridWidth) * gridDepth, 0);
+    for (int rz = 0; rz < gridDepth; ++rz) {
+        for (int rx = 0; rx < gridWidth; ++rx) {
+            int regionX = gridRegionXStart + rx;
+            int regionZ = gridRegionZStart + rz;
+            auto header = LoadRegionHeader(regionX, regionZ);
+            if (header) {
+                // 统计导出范围覆盖的区块占该 region 已有区块的比例,超过阈值则整文件映射,否则按区块读取
+                int existing = 0, requested = 0;
+                for (int lz = 0; lz < 32; ++lz) {
+                    for (int lx = 0; lx < 32; ++lx) {
+                        if (!header->HasChunk(lx, lz)) continue;
+                        ++existing;
+                        int cx = regionX * 32 + lx;
+                        int cz = regionZ * 32 + lz;
+                        if (cx >= chunkXStart && cx <= chunkXEnd && cz >= chunkZStart && cz <= chunkZEnd) {
+                            ++requested;
+                        }
+                    }
+                }
+                regionMapWholeGrid[rz * gridWidth + rx] = (existing > 0 && requested * 2 >= existing) ? 1 : 0;
+            }
+            regionHeaderGrid[rz * gridWidth + rx] = std::move(header);
+        }
     }
 
-    // 将文件内容读取到文件数据中
-    std::vector<char> fileData;
-    fileData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
-    if (fileData.empty()) {
+    std::unique_lock<std::shared_mutex> lock(regionHeaderExtraMutex);
+    regionHeaderExtra.clear();
+}
+
+const RegionHeader* GetRegionHeader(int regionX, int regionZ) {
+    int gx = regionX - gridRegionXStart;
+    int gz = regionZ - gridRegionZStart;
+    if (gx >= 0 && gx < gridWidth && gz >= 0 && gz < gridDepth) {
+        return regionHeaderGrid[gz * gridWidth + gx].get();
+    }
+
+    auto regionKey = std::make_pair(regionX, regionZ);
+    {
+        std::shared_lock<std::shared_mutex> lock(regionHeaderExtraMutex);
+        auto it = regionHeaderExtra.find(regionKey);
+        if (it != regionHeaderExtra.end()) {
+            return it->second.get();
+        }
+    }
+    // 不存在的 region 不缓存空项;重复查询先经 presentRegions 拦截,不会反复探测文件系统
+    auto header = LoadRegionHeader(regionX, regionZ);
+    if (!header) {
+        return nullptr;
+    }
+    std::unique_lock<std::shared_mutex> lock(regionHeaderExtraMutex);
+    auto it = regionHeaderExtra.try_emplace(regionKey, std::move(header)).first;
+    return it->second.get();
+}
+
+// 该 region 是否应整文件映射(仅索引范围内且大部分区块被请求时)
+static bool ShouldMapWholeRegion(int regionX, int regionZ) {
+    int gx = regionX - gridRegionXStart;
+    int gz = regionZ - gridRegionZStart;
+    if (gx >= 0 && gx < gridWidth && gz >= 0 && gz < gridDepth) {
+        return regionMapWholeGrid[gz * gridWidth + gx] != 0;
+    }
+    return false;
+}
+
+// --------------------------------------------------------------------------------
+// RegionFile:只读文件(整文件映射或按区块读取)
+// --------------------------------------------------------------------------------
+std::shared_ptr<RegionFile> RegionFile::Open(const std::string& filePath, bool mapWholeFile) {
+    std::shared_ptr<RegionFile> region(new RegionFile());
+#ifdef _WIN32
+    std::wstring widePath = string_to_wstring(filePath);
+    HANDLE file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    region->fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
         std::cerr << "错误: 文件为空或读取失败!" << std::endl;
-        return {};  // 返回空vector表示失败
+        return nullptr;
+    }
+    if (!mapWholeFile) {
+        return region;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        std::cerr << "错误: 映射文件失败!" << std::endl;
+        return nullptr;
     }
+    region->mappingHandle = mapping;
 
-    // 返回读取到的文件数据
-    return fileData;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        std::cerr << "错误: 映射文件失败!" << std::endl;
+        return nullptr;
+    }
+    region->data = static_cast<const char*>(view);
+    region->size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    region->fd = fd;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        std::cerr << "错误: 文件为空或读取失败!" << std::endl;
+        return nullptr;
+    }
+    if (!mapWholeFile) {
+        return region;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+        std::cerr << "错误: 映射文件失败!" << std::endl;
+        return nullptr;
+    }
+    region->data = static_cast<const char*>(view);
+    region->size = static_cast<size_t>(st.st_size);
+#endif
+    return region;
 }
 
+size_t RegionFile::ReadAt(uint64_t offset, char* dst, size_t length) const {
+    if (data) {
+        // 整文件映射模式直接从映射中复制
+        if (offset >= size) return 0;
+        size_t n = std::min<size_t>(length, size - static_cast<size_t>(offset));
+        std::memcpy(dst, data + offset, n);
+        return n;
+    }
+    size_t total = 0;
+    while (total < length) {
+#ifdef _WIN32
+        // 同步句柄上的 OVERLAPPED 读取按指定偏移进行,不依赖共享的文件指针
+        OVERLAPPED ov = {};
+        uint64_t pos = offset + total;
+        ov.Offset = static_cast<DWORD>(pos & 0xFFFFFFFFull);
+        ov.OffsetHigh = static_cast<DWORD>(pos >> 32);
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(length - total, 1u << 30));
+        DWORD bytesRead = 0;
+        if (!ReadFile(static_cast<HANDLE>(fileHandle), dst + total, chunk, &bytesRead, &ov) || bytesRead == 0) {
+            break;
+        }
+        total += bytesRead;
+#else
+        ssize_t n = pread(fd, dst + total, length - total, static_cast<off_t>(offset + total));
+        if (n <= 0) {
+            break;
+        }
+        total += static_cast<size_t>(n);
+#endif
+    }
+    return total;
+}
+
+void RegionFile::AdviseWillNeed(uint64_t offset, uint64_t length) const {
+#ifdef _WIN32
+    // Windows 下由系统自行预读,不做额外处理
+    (void)offset;
+    (void)length;
+#else
+    if (data) {
+        // madvise 要求起始地址按页对齐
+        if (offset >= size) return;
+        const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        uint64_t begin = offset & ~(pageSize - 1);
+        uint64_t end = std::min<uint64_t>(offset + length, size);
+        madvise(const_cast<char*>(data) + begin, static_cast<size_t>(end - begin), MADV_WILLNEED);
+    } else if (fd >= 0) {
+#ifdef POSIX_FADV_WILLNEED
+        posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+#endif
+    }
+#endif
+}
+
+RegionFile::~RegionFile() {
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+#else
+    if (data) munmap(const_cast<char*>(data), size);
+    if (fd >= 0) close(fd);
+#endif
+}
 
-const std::vector<char>& GetRegionFromCache(int regionX, int regionZ) {
+// --------------------------------------------------------------------------------
+// region 缓存(LRU)
+// --------------------------------------------------------------------------------
+RegionFilePtr GetRegionFromCache(int regionX, int regionZ) {
     auto regionKey = std::make_pair(regionX, regionZ);
+    {
+        std::lock_guard<std::mutex> lock(regionCacheMutex);
+        auto it = regionCache.find(regionKey);
+        if (it != regionCache.end()) {
+            regionLru.splice(regionLru.begin(), regionLru, it->second.lruIt);
+            return it->second.file;
+        }
+    }
+
+    // 在锁外打开并映射文件,避免阻塞其他 region 的查询;文件头索引中不存在的 region 不再探测文件系统
+    RegionFilePtr file;
+    if (GetRegionHeader(regionX, regionZ)) {
+        file = RegionFile::Open(BuildRegionFilePath(GetRegionDirectoryPath(), regionX, regionZ),
+            ShouldMapWholeRegion(regionX, regionZ));
+    }
+
+    if (!file) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(regionCacheMutex);
     auto it = regionCache.find(regionKey);
-    if (it == regionCache.end()) {
-        std::string regionDir = GetRegionDirectory();
-        std::vector<char> fileData = ReadFileToMemory(regionDir, regionX, regionZ);
-        auto result = regionCache.emplace(regionKey, std::move(fileData));
-        it = result.first;
+    if (it != regionCache.end()) {
+        // 其他线程已抢先映射,丢弃本次结果
+        regionLru.splice(regionLru.begin(), regionLru, it->second.lruIt);
+        return it->second.file;
+    }
+    regionLru.push_front(regionKey);
+    regionCache.emplace(regionKey, RegionCacheEntry{ file, regionLru.begin() });
+    regionCacheBytes += RegionCacheCost(*file);
+    return file;
+}
+
+void TrimRegionCache() {
+    const size_t budget = config.regionCacheBudgetMB * 1024 * 1024;
+    std::lock_guard<std::mutex> lock(regionCacheMutex);
+    // 从最久未使用的一端开始淘汰,跳过仍被加载线程引用的 region
+    auto lruIt = regionLru.end();
+    while (regionCacheBytes > budget && lruIt != regionLru.begin()) {
+        --lruIt;
+        auto it = regionCache.find(*lruIt);
+        const RegionFilePtr& file = it->second.file;
+        if (file.use_count() > 1) {
+            continue;
+        }
+        regionCacheBytes -= RegionCacheCost(*file);
+        regionCache.erase(it);
+        lruIt = regionLru.erase(lruIt);
     }
-    return it->second;
 }
 
-// 新增:判断指定 chunk 是否存在于 region 文件中
+void ClearRegionCache() {
+    std::lock_guard<std::mutex> lock(regionCacheMutex);
+    regionCache.clear();
+    regionLru.clear();
+    regionCacheBytes = 0;
+}
+
+// 判断指定 chunk 是否存在于 region 文件中(仅查询文件头索引)
 bool HasChunk(int chunkX, int chunkZ) {
     int regionX, regionZ;
     chunkToRegion(chunkX, chunkZ, regionX, regionZ);
-    std::string regionDir = GetRegionDirectory();
-    std::ostringstream filePathStream;
-    filePathStream << regionDir << "/r." << regionX << "." << regionZ << ".mca";
-    std::string filePath = filePathStream.str();
-    if (!std::filesystem::exists(filePath)) {
-        return false;
-    }
-    const auto& data = GetRegionFromCache(regionX, regionZ);
-    int localX = chunkX - regionX * 32;
-    int localZ = chunkZ - regionZ * 32;
-    if (localX < 0 || localX >= 32 || localZ < 0 || localZ >= 32) {
-        return false;
-    }
-    size_t index = (localX + localZ * 32) * 4;
-    if (data.size() < index + 4) {
-        return false;
-    }
-    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.data());
-    uint32_t offset = ((uint32_t)bytes[index] << 16) | ((uint32_t)bytes[index + 1] << 8) | (uint32_t)bytes[index + 2];
-    return offset != 0;
-}
\ No newline at end of file
+    const RegionHeader* header = GetRegionHeader(regionX, regionZ);
+    return header && header->HasChunk(chunkX - regionX * 32, chunkZ - regionZ * 32);
+}
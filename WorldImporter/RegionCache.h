@@ -1,13 +1,86 @@
 #pragma once
 
-#include <unordered_map>
-#include <vector>
-#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
 #include "hashutils.h"
 #include "config.h"
 
-extern std::unordered_map<std::pair<int, int>, std::vector<char>, pair_hash> regionCache;
-const std::vector<char>& GetRegionFromCache(int regionX, int regionZ);
+// 只读打开的 .mca 文件,两种访问模式:
+//   整文件映射:导出需要该 region 的大部分区块时使用,Data() 为整个文件
+//   按区块读取:只保留文件句柄,通过 ReadAt 读取单个区块的扇区,Data() 为空
+// 文件在最后一个持有者释放后才关闭,因此淘汰不会影响正在解析区块的线程
+class RegionFile {
+public:
+    // 打开 region 文件,mapWholeFile 为 true 时映射整个文件;文件不存在或为空时返回 nullptr
+    static std::shared_ptr<RegionFile> Open(const std::string& filePath, bool mapWholeFile);
+    ~RegionFile();
 
-// 新增:判断指定 chunk 是否存在于 region 文件中
-bool HasChunk(int chunkX, int chunkZ);
\ No newline at end of file
+    RegionFile(const RegionFile&) = delete;
+    RegionFile& operator=(const RegionFile&) = delete;
+
+    // 零拷贝访问整个文件内容(仅整文件映射模式)
+    std::span<const char> Data() const { return { data, size }; }
+    size_t Size() const { return size; }
+    bool IsMapped() const { return data != nullptr; }
+
+    // 从文件偏移 offset 处读取最多 length 字节到 dst,返回实际读取的字节数(线程安全)
+    size_t ReadAt(uint64_t offset, char* dst, size_t length) const;
+
+    // 预读提示:即将读取 [offset, offset + length),由系统提前把这段数据读入页缓存
+    void AdviseWillNeed(uint64_t offset, uint64_t length) const;
+
+private:
+    RegionFile() = default;
+
+    const char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+using RegionFilePtr = std::shared_ptr<const RegionFile>;
+
+// 已解析的 region 文件头(前 8KB):每个区块的扇区偏移、扇区数与修改时间戳
+// 下标为 localX + localZ * 32
+struct RegionHeader {
+    uint32_t sectorOffsets[1024];
+    uint8_t sectorCounts[1024];
+    uint32_t timestamps[1024];
+
+    bool HasChunk(int localX, int localZ) const {
+        int i = localX + localZ * 32;
+        return sectorOffsets[i] != 0 && sectorCounts[i] != 0;
+    }
+};
+
+// 在导出开始前调用:解析一次 region 目录,扫描已存在的 region 文件,
+// 并预先解析覆盖给定区块范围的所有 region 文件头
+void BuildRegionIndex(int chunkXStart, int chunkXEnd, int chunkZStart, int chunkZEnd);
+
+// 当前维度解析后的 region 目录(首次调用时解析并缓存)
+const std::string& GetRegionDirectoryPath();
+
+// 获取 region 文件头,region 文件不存在或损坏时返回 nullptr
+// 索引范围外的 region 按需解析并缓存
+const RegionHeader* GetRegionHeader(int regionX, int regionZ);
+
+// 获取 region 文件(按需打开),region 文件不存在时返回 nullptr
+// 访问模式由 BuildRegionIndex 时统计的区块需求比例决定,索引范围外的 region 按区块读取
+RegionFilePtr GetRegionFromCache(int regionX, int regionZ);
+
+// 按 LRU 顺序淘汰未被引用的 region,直到映射总量(每个打开的文件另计名义开销)不超过 config.regionCacheBudgetMB
+// 应在一个批次完成并卸载区块后调用
+void TrimRegionCache();
+
+// 释放所有 region 映射
+void ClearRegionCache();
+
+// 判断指定 chunk 是否存在于 region 文件中(仅查询文件头索引,不打开 region 文件)
+bool HasChunk(int chunkX, int chunkZ);
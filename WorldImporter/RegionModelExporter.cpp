@@ -13,6 +13,7 @@
 #include "ModelDeduplicator.h"
 #include "hashutils.h"
 #include "ChunkLoader.h"
+#include "RegionCache.h"
 #include "ChunkGenerator.h"
 #include "ChunkGroupAllocator.h"
 #include <limits>
@@ -54,6 +55,9 @@ void RegionModelExporter::ExportModels(const string& outputName) {
     int totalChunksX = expandedChunkXEnd - expandedChunkXStart + 1;
     int totalChunksZ = expandedChunkZEnd - expandedChunkZStart + 1;
     int totalChunks = totalChunksX * totalChunksZ;
+
+    // 一次性解析 region 目录与文件头,后续区块存在性查询均为 O(1)
+    BuildRegionIndex(expandedChunkXStart, expandedChunkXEnd, expandedChunkZStart, expandedChunkZEnd);
     monitor.UpdateProgress("区块LOD计算", 0, totalChunks);
 
     // 预先计算所有区块的LOD等级
@@ -132,6 +136,12 @@ void RegionModelExporter::ExportModels(const string& outputName) {
         }
     };
 
+    // 完整模型在网格生成时已按体素贪心合并(useGreedyMesh),LOD 模型没有,仍需按面合并
+    auto mergedInVoxelSpace = [](const ChunkTask& task) {
+        return !config.activeLOD || (task.lodLevel == 0.0f && config.LOD0renderDistance != 0);
+    };
+    std::atomic<bool> faceGreedyNeeded{ false }; // 是否有 LOD 模型进入了 finalMergedModel
+
     std::mutex finalModelMutex;
     std::mutex materialsMutex;
     std::mutex progressMutex;
@@ -173,6 +183,9 @@ void RegionModelExporter::ExportModels(const string& outputName) {
         int bExpXStart, bExpXEnd, bExpZStart, bExpZEnd;
         std::tie(bExpXStart, bExpXEnd, bExpZStart, bExpZEnd) = get_batch_expanded_coords(batch);
 
+        // 子区块缓存的稠密网格覆盖当前批次(含边界),网格外保留的区块转入哈希表
+        SetSectionCacheGrid(bExpXStart, bExpXEnd, bExpZStart, bExpZEnd);
+
         size_t beforeLoad = CountLoadedChunks();
         ChunkLoader::LoadChunks(bExpXStart, bExpXEnd, bExpZStart, bExpZEnd,
                                 sectionYStart, sectionYEnd);
@@ -182,6 +195,9 @@ void RegionModelExporter::ExportModels(const string& outputName) {
         // 处理天空光照邻居标志(在模型线程前执行,避免写冲突)
         UpdateSkyLightNeighborFlags();
 
+        // 并行烘焙本批次加载时新发现的方块状态,网格生成线程只读取已烘焙的模型
+        BakePendingBlockstates();
+
         // ---------- 处理当前批次 ----------
         monitor.SetStatus(TaskStatus::GENERATING_MODELS, "生成批次 " + to_string(batchId) + " 模型");
         const auto& groupsInBatch = batch.groups;
@@ -217,7 +233,9 @@ void RegionModelExporter::ExportModels(const string& outputName) {
                     size_t processedInGroup = 0;
 
                     // 合并组内所有区块模型
+                    bool groupMergedInVoxelSpace = true;
                     for (const auto& task : group.tasks) {
+                        groupMergedInVoxelSpace = groupMergedInVoxelSpace && mergedInVoxelSpace(task);
                         // 为当前区块生成生物群系地图数据 (如果尚未生成)
                         std::pair<int, int> chunkKey = {task.chunkX, task.chunkZ};
                         {
@@ -273,6 +291,9 @@ void RegionModelExporter::ExportModels(const string& outputName) {
                     }
                     if (groupModel.vertices.empty()) continue;
                     if (config.exportFullModel) {
+                        if (!groupMergedInVoxelSpace) {
+                            faceGreedyNeeded.store(true, std::memory_order_relaxed);
+                        }
                         mergeToFinalModel(std::move(groupModel));
                     } else {
                         // 去重处理
@@ -286,7 +307,8 @@ void RegionModelExporter::ExportModels(const string& outputName) {
                             monitor.SetStatus(TaskStatus::DEDUPLICATING_FACES, "DeduplicateFaces");
                             ModelDeduplicator::DeduplicateFaces(groupModel);
                             
-                            if (config.useGreedyMesh) {
+                            // 立方体的面已在体素空间合并,按面合并只对含 LOD 模型的组执行
+                            if (config.useGreedyMesh && !groupMergedInVoxelSpace) {
                                 monitor.SetStatus(TaskStatus::GREEDY_MESHING, "GreedyMesh");
                                 ModelDeduplicator::GreedyMesh(groupModel);
                             }
@@ -325,6 +347,12 @@ void RegionModelExporter::ExportModels(const string& outputName) {
         size_t afterUnload = CountLoadedChunks();
         size_t unloadedCnt = (beforeUnload > afterUnload) ? (beforeUnload - afterUnload) : 0;
 
+        // 网格生成线程已结束,释放本批次替换与卸载的子区块(不等到下一次 SetGrid,最后一批也会释放)
+        ReclaimSectionCache();
+
+        // 按预算淘汰不再使用的 region 映射
+        TrimRegionCache();
+
         std::cout << "批次" << batchId << "完成：新加载区块 " << newlyLoaded << "," << unloadedCnt << "," << afterUnload<<std::endl;
     }
 
@@ -337,10 +365,11 @@ void RegionModelExporter::ExportModels(const string& outputName) {
     Biome::ExportToPNG("waterFog.png", BiomeColorType::WaterFog);
     Biome::ExportToPNG("fog.png", BiomeColorType::Fog);
     Biome::ExportToPNG("sky.png", BiomeColorType::Sky);
+    ClearRegionCache();
     // 最终导出处理
     if (config.exportFullModel && !finalMergedModel.vertices.empty()) {
         monitor.SetStatus(TaskStatus::DEDUPLICATING_VERTICES, "DeduplicateModel");
-        ModelDeduplicator::DeduplicateModel(finalMergedModel);
+        ModelDeduplicator::DeduplicateModel(finalMergedModel, faceGreedyNeeded.load());
         
         monitor.SetStatus(TaskStatus::EXPORTING_MODELS, "CreateModelFiles");
         CreateModelFiles(finalMergedModel, outputName);
@@ -10,7 +10,7 @@
 #include "include/json.hpp"
 extern std::unordered_map<std::tuple<int, int, int>, float, TupleHash> g_chunkLODs;
 
-extern std::unordered_map<std::string, std::unordered_map<std::string, ModelData>> BlockModelCache;
+extern std::unordered_map<std::string, std::unordered_map<std::string, BakedModelPtr>> BlockModelCache;
 
 extern std::unordered_map<std::string,std::unordered_map<std::string, std::vector<WeightedModelData>>> VariantModelCache; // variant随机模型缓存
 
@@ -0,0 +1,425 @@
+// SectionMesher.cpp
+#include "SectionMesher.h"
+#include "block.h"
+#include "blockstate.h"
+#include "Fluid.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+std::shared_mutex materialIdMutex;
+std::unordered_map<std::string, int> materialIds;
+
+// 面方向 -> neighborIsAir 下标(与 BlockIdWithNeighbors 的方向顺序一致),不参与剔除的方向为 -1
+constexpr int NeighborIndex(FaceType dir) {
+    switch (dir) {
+    case FaceType::UP:    return 0;
+    case FaceType::DOWN:  return 1;
+    case FaceType::WEST:  return 2;
+    case FaceType::EAST:  return 3;
+    case FaceType::NORTH: return 4;
+    case FaceType::SOUTH: return 5;
+    default:              return -1;
+    }
+}
+
+constexpr int kNeighborOffsets[6][3] = {
+    {0, 1, 0}, {0, -1, 0}, {-1, 0, 0}, {1, 0, 0}, {0, 0, -1}, {0, 0, 1}
+};
+
+// 各方向的面所在平面:法线轴、面内 a 轴(列)与 b 轴(行)、是否位于方块正方向一侧(坐标 1)
+// 轴编号 0/1/2 对应 x/y/z,方向顺序同 NeighborIndex
+struct FaceAxes {
+    int normal;
+    int col;
+    int row;
+    bool positive;
+};
+constexpr FaceAxes kFaceAxes[6] = {
+    {1, 0, 2, true},  {1, 0, 2, false},
+    {0, 2, 1, false}, {0, 2, 1, true},
+    {2, 0, 1, false}, {2, 0, 1, true}
+};
+
+// 坐标是否为 0 或 1(方块边界或贴图边界)
+bool UnitBit(float value, int& bit) {
+    constexpr float eps = 1e-4f;
+    if (std::fabs(value) < eps) { bit = 0; return true; }
+    if (std::fabs(value - 1.0f) < eps) { bit = 1; return true; }
+    return false;
+}
+
+// 合并键:输出材质下标、4 个角点顺序(8 位)与 UV 映射(3 位)
+constexpr int GreedyKey(int outMaterial, uint8_t corners, uint8_t mapping) {
+    return (outMaterial << 11) | (corners << 3) | mapping;
+}
+
+} // namespace
+
+int InternMaterial(const Material& material) {
+    {
+        std::shared_lock<std::shared_mutex> lock(materialIdMutex);
+        auto it = materialIds.find(material.name);
+        if (it != materialIds.end()) return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(materialIdMutex);
+    return materialIds.try_emplace(material.name, static_cast<int>(materialIds.size())).first->second;
+}
+
+SectionMesher& SectionMesher::ThreadLocal() {
+    thread_local SectionMesher mesher;
+    return mesher;
+}
+
+void SectionMesher::Begin(const ModelData& out) {
+    for (int id : boundMaterials) {
+        materialSlots[id] = -1;
+    }
+    boundMaterials.clear();
+    boundMaterialCount = 0;
+    SyncMaterials(out);
+}
+
+void SectionMesher::SyncMaterials(const ModelData& out) {
+    for (; boundMaterialCount < out.materials.size(); ++boundMaterialCount) {
+        int id = InternMaterial(out.materials[boundMaterialCount]);
+        if (static_cast<size_t>(id) >= materialSlots.size()) {
+            materialSlots.resize(id + 1, -1);
+        }
+        // 与 MergeModelsDirectly 一致,同名材质使用第一次出现的下标
+        if (materialSlots[id] < 0) {
+            materialSlots[id] = static_cast<int>(boundMaterialCount);
+            boundMaterials.push_back(id);
+        }
+    }
+}
+
+int SectionMesher::OutputMaterial(const BakedModel& baked, int materialIndex, ModelData& out) {
+    if (materialIndex < 0 || static_cast<size_t>(materialIndex) >= baked.materialIds.size()) {
+        return 0; // 与 MergeModelsDirectly 一致,无效材质使用第一个材质
+    }
+    int id = baked.materialIds[materialIndex];
+    if (static_cast<size_t>(id) >= materialSlots.size()) {
+        materialSlots.resize(id + 1, -1);
+    }
+    if (materialSlots[id] < 0) {
+        materialSlots[id] = static_cast<int>(out.materials.size());
+        boundMaterials.push_back(id);
+        out.materials.push_back(baked.model->materials[materialIndex]);
+        boundMaterialCount = out.materials.size();
+    }
+    return materialSlots[id];
+}
+
+// 判断面是否占满方块的一个面且贴图完整覆盖,是则记录角点顺序与 UV 映射
+static bool AnalyzeCubeFace(const ModelData& model, const Face& face, int dir, uint8_t& corners, uint8_t& mapping) {
+    const FaceAxes& axes = kFaceAxes[dir];
+    const size_t vertexCount = model.vertices.size() / 3;
+    const size_t uvCount = model.uvCoordinates.size() / 2;
+    unsigned seen = 0;
+    bool uA = true, uAFlip = true, uB = true, uBFlip = true;
+    bool vA = true, vAFlip = true, vB = true, vBFlip = true;
+    corners = 0;
+    for (int j = 0; j < 4; ++j) {
+        int vi = face.vertexIndices[j];
+        int ti = face.uvIndices[j];
+        if (vi < 0 || static_cast<size_t>(vi) >= vertexCount || ti < 0 || static_cast<size_t>(ti) >= uvCount) return false;
+        const float* p = &model.vertices[static_cast<size_t>(vi) * 3];
+        int n, a, b, u, v;
+        if (!UnitBit(p[axes.normal], n) || n != (axes.positive ? 1 : 0)) return false;
+        if (!UnitBit(p[axes.col], a) || !UnitBit(p[axes.row], b)) return false;
+        if (!UnitBit(model.uvCoordinates[static_cast<size_t>(ti) * 2], u) ||
+            !UnitBit(model.uvCoordinates[static_cast<size_t>(ti) * 2 + 1], v)) return false;
+        seen |= 1u << (a | (b << 1));
+        corners |= static_cast<uint8_t>((a | (b << 1)) << (2 * j));
+        uA = uA && u == a;  uAFlip = uAFlip && u != a;
+        uB = uB && u == b;  uBFlip = uBFlip && u != b;
+        vA = vA && v == a;  vAFlip = vAFlip && v != a;
+        vB = vB && v == b;  vBFlip = vBFlip && v != b;
+    }
+    if (seen != 0xF) return false;
+    if ((uA || uAFlip) && (vB || vBFlip)) {
+        mapping = static_cast<uint8_t>((uA ? 0 : 2) | (vB ? 0 : 4));
+        return true;
+    }
+    if ((uB || uBFlip) && (vA || vAFlip)) {
+        mapping = static_cast<uint8_t>(1 | (uB ? 0 : 2) | (vA ? 0 : 4));
+        return true;
+    }
+    return false;
+}
+
+void SectionMesher::Bake(BakedModel& baked) {
+    baked.materialIds.clear();
+    for (const Material& material : baked.model->materials) {
+        baked.materialIds.push_back(InternMaterial(material));
+    }
+
+    // 完整立方体:恰好 6 个面,每个方向一个,且都可以平铺合并
+    // 动态材质的 UV 只覆盖贴图条中的一帧,平铺超过 1 会采样到其他帧,这类方块逐方块输出
+    baked.fullCube = false;
+    if (baked.model->faces.size() != 6) return;
+    unsigned directions = 0;
+    for (const Face& face : baked.model->faces) {
+        if (face.materialIndex < 0 || static_cast<size_t>(face.materialIndex) >= baked.model->materials.size() ||
+            baked.model->materials[face.materialIndex].type == ANIMATED) return;
+        int dir = NeighborIndex(face.faceDirection);
+        if (dir < 0 || (directions & (1u << dir))) return;
+        CubeFace& cubeFace = baked.cubeFaces[dir];
+        if (!AnalyzeCubeFace(*baked.model, face, dir, cubeFace.corners, cubeFace.mapping)) return;
+        cubeFace.materialIndex = face.materialIndex;
+        directions |= 1u << dir;
+    }
+    baked.fullCube = true;
+}
+
+const SectionMesher::BakedModel* SectionMesher::ModelForBlock(int blockId) {
+    const ModelData* model = PickRandomModel(GetBlockModelRefs(blockId));
+    if (!model || model->vertices.empty()) return nullptr;
+
+    auto [it, inserted] = bakedModels.try_emplace(model);
+    if (inserted) {
+        it->second.model = model;
+        Bake(it->second);
+    }
+    return &it->second;
+}
+
+void SectionMesher::MeshSection(const SectionVolume& volume, ModelData& out) {
+    Begin(out);
+    greedyActive = config.useGreedyMesh;
+    if (greedyActive) {
+        std::fill(&greedyMasks[0][0][0], &greedyMasks[0][0][0] + 6 * 16 * 16, static_cast<uint16_t>(0));
+    }
+    const int originX = volume.OriginX();
+    const int originY = volume.OriginY();
+    const int originZ = volume.OriginZ();
+    for (int x = 0; x < 16; ++x) {
+        if (originX + x < config.minX || originX + x > config.maxX) continue;
+        for (int z = 0; z < 16; ++z) {
+            if (originZ + z < config.minZ || originZ + z > config.maxZ) continue;
+            for (int y = 0; y < 16; ++y) {
+                if (originY + y < config.minY || originY + y > config.maxY) continue;
+                MeshVoxel(volume, x, y, z, out);
+            }
+        }
+    }
+    if (greedyActive) {
+        MeshGreedyFaces(volume, out);
+        greedyActive = false;
+    }
+}
+
+void SectionMesher::MeshBlock(const SectionVolume& volume, int x, int y, int z, ModelData& out) {
+    SyncMaterials(out);
+    MeshVoxel(volume, x, y, z, out);
+}
+
+void SectionMesher::MeshVoxel(const SectionVolume& volume, int x, int y, int z, ModelData& out) {
+    std::array<bool, 6> neighbors; // 邻居是否为空气
+    std::array<int, 10> fluidLevels; // 流体液位
+    int id = volume.BlockIdWithNeighbors(x, y, z, neighbors.data(), fluidLevels.data());
+    const BlockTraits& traits = GetBlockTraits(id);
+    if (traits.isAirBlock) return;
+
+    if (config.exportLightBlockOnly && !traits.isLightBlock) {
+        return;
+    }
+    if (config.cullCave) {
+        if (volume.SkyLight(x, y, z) == -1) return;
+    }
+
+    const int worldX = volume.OriginX() + x;
+    const int worldY = volume.OriginY() + y;
+    const int worldZ = volume.OriginZ() + z;
+
+    if (traits.level <= -1) {
+        const BakedModel* baked = ModelForBlock(id);
+        if (!baked) return;
+        if (greedyActive && baked->fullCube) {
+            RecordCubeFaces(*baked, neighbors, x, y, z, out);
+        } else {
+            Emit(*baked, neighbors, worldX, worldY, worldZ, out);
+        }
+        return;
+    }
+
+    // 流体与含水方块:流体模型取决于周围液位,每个方块单独生成
+    const std::string& blockName = GetBlockById(id).name;
+    // 需要修改面的剔除方向,复制到临时存储(复用其容量)
+    ModelData& blockModel = scratchData;
+    const ModelData* cached = PickRandomModel(GetBlockModelRefs(id));
+    if (cached) {
+        blockModel = *cached;
+    } else {
+        blockModel.vertices.clear();
+        blockModel.uvCoordinates.clear();
+        blockModel.faces.clear();
+        blockModel.materials.clear();
+    }
+    if (blockModel.vertices.empty()) {
+        blockModel = GenerateFluidModel(fluidLevels, blockName);
+        AssignFluidMaterials(blockModel, blockName);
+    }
+    else {
+        ModelData liquidModel = GenerateFluidModel(fluidLevels, "minecraft:water[level:0]");
+        AssignFluidMaterials(liquidModel, "minecraft:water[level:0]");
+
+        // 只对有流体方向的面设置为不剔除:相邻方向为流体或含有流体时,该面不剔除
+        for (auto& face : blockModel.faces) {
+            int neighborIdx = NeighborIndex(face.faceDirection);
+            if (neighborIdx < 0) continue;
+            const int* offset = kNeighborOffsets[neighborIdx];
+            if (volume.Flags(x + offset[0], y + offset[1], z + offset[2]) & BLOCK_FLAG_HAS_FLUID) {
+                face.faceDirection = FaceType::DO_NOT_CULL;
+            }
+        }
+
+        blockModel = MergeFluidModelData(blockModel, liquidModel);
+    }
+    scratchModel.model = &scratchData;
+    Bake(scratchModel);
+    Emit(scratchModel, neighbors, worldX, worldY, worldZ, out);
+}
+
+void SectionMesher::Emit(const BakedModel& baked, const std::array<bool, 6>& neighborIsAir, int worldX, int worldY, int worldZ, ModelData& out) {
+    const ModelData& model = *baked.model;
+    if (model.vertices.empty()) return;
+
+    const int vertexCount = static_cast<int>(model.vertices.size() / 3);
+    const int uvCount = static_cast<int>(model.uvCoordinates.size() / 2);
+    vertexRemap.assign(vertexCount, -1);
+    uvRemap.assign(uvCount, -1);
+
+    for (const Face& face : model.faces) {
+        // 邻居存在(非空气)时剔除该面,DO_NOT_CULL 与未知方向的面始终保留
+        int neighborIdx = NeighborIndex(face.faceDirection);
+        if (neighborIdx >= 0 && !neighborIsAir[neighborIdx]) continue;
+
+        bool valid = true;
+        for (int j = 0; j < 4; ++j) {
+            valid = valid && face.vertexIndices[j] >= 0 && face.vertexIndices[j] < vertexCount
+                && face.uvIndices[j] >= 0 && face.uvIndices[j] < uvCount;
+        }
+        if (!valid) continue;
+
+        // 只输出被保留的面用到的顶点与 UV,平移到方块的世界坐标
+        Face emitted;
+        for (int j = 0; j < 4; ++j) {
+            int v = face.vertexIndices[j];
+            if (vertexRemap[v] < 0) {
+                vertexRemap[v] = static_cast<int>(out.vertices.size() / 3);
+                out.vertices.push_back(model.vertices[v * 3] + worldX);
+                out.vertices.push_back(model.vertices[v * 3 + 1] + worldY);
+                out.vertices.push_back(model.vertices[v * 3 + 2] + worldZ);
+            }
+            emitted.vertexIndices[j] = vertexRemap[v];
+
+            int uv = face.uvIndices[j];
+            if (uvRemap[uv] < 0) {
+                uvRemap[uv] = static_cast<int>(out.uvCoordinates.size() / 2);
+                out.uvCoordinates.push_back(model.uvCoordinates[uv * 2]);
+                out.uvCoordinates.push_back(model.uvCoordinates[uv * 2 + 1]);
+            }
+            emitted.uvIndices[j] = uvRemap[uv];
+        }
+        emitted.materialIndex = OutputMaterial(baked, face.materialIndex, out);
+        emitted.faceDirection = face.faceDirection;
+        out.faces.push_back(emitted);
+    }
+}
+
+void SectionMesher::RecordCubeFaces(const BakedModel& baked, const std::array<bool, 6>& neighborIsAir, int x, int y, int z, ModelData& out) {
+    const int local[3] = { x, y, z };
+    for (int dir = 0; dir < 6; ++dir) {
+        if (!neighborIsAir[dir]) continue;
+        const CubeFace& cubeFace = baked.cubeFaces[dir];
+        const FaceAxes& axes = kFaceAxes[dir];
+        const int slice = local[axes.normal];
+        const int row = local[axes.row];
+        const int col = local[axes.col];
+        int outMaterial = OutputMaterial(baked, cubeFace.materialIndex, out);
+        greedyKeys[dir][slice][row][col] = GreedyKey(outMaterial, cubeFace.corners, cubeFace.mapping);
+        greedyMasks[dir][slice][row] |= static_cast<uint16_t>(1u << col);
+    }
+}
+
+void SectionMesher::MeshGreedyFaces(const SectionVolume& volume, ModelData& out) {
+    for (int dir = 0; dir < 6; ++dir) {
+        for (int slice = 0; slice < 16; ++slice) {
+            uint16_t (&masks)[16] = greedyMasks[dir][slice];
+            const int (&keys)[16][16] = greedyKeys[dir][slice];
+            for (int row = 0; row < 16; ++row) {
+                while (masks[row]) {
+                    // 从行内最低的待合并列开始,先沿行扩展,再逐行向下扩展整段
+                    const int col = std::countr_zero(masks[row]);
+                    const int key = keys[row][col];
+                    int width = 1;
+                    while (col + width < 16 && (masks[row] & (1u << (col + width))) && keys[row][col + width] == key) {
+                        ++width;
+                    }
+                    const unsigned run = ((1u << width) - 1) << col;
+                    int height = 1;
+                    while (row + height < 16 && (masks[row + height] & run) == run) {
+                        const int* next = keys[row + height];
+                        bool same = true;
+                        for (int c = col; c < col + width && same; ++c) {
+                            same = next[c] == key;
+                        }
+                        if (!same) break;
+                        ++height;
+                    }
+                    for (int r = row; r < row + height; ++r) {
+                        masks[r] &= static_cast<uint16_t>(~run);
+                    }
+                    EmitGreedyQuad(volume, dir, slice, col, row, width, height, key, out);
+                }
+            }
+        }
+    }
+}
+
+void SectionMesher::EmitGreedyQuad(const SectionVolume& volume, int dir, int slice, int col, int row, int width, int height, int key, ModelData& out) {
+    const FaceAxes& axes = kFaceAxes[dir];
+    const int origin[3] = { volume.OriginX(), volume.OriginY(), volume.OriginZ() };
+    const uint8_t corners = static_cast<uint8_t>((key >> 3) & 0xFF);
+    const bool uAlongRow = (key & 1) != 0;
+    const bool uFlip = (key & 2) != 0;
+    const bool vFlip = (key & 4) != 0;
+
+    Face face;
+    const int vertexBase = static_cast<int>(out.vertices.size() / 3);
+    const int uvBase = static_cast<int>(out.uvCoordinates.size() / 2);
+    for (int j = 0; j < 4; ++j) {
+        const int a = (corners >> (2 * j)) & 1;
+        const int b = (corners >> (2 * j + 1)) & 1;
+        float position[3];
+        position[axes.normal] = static_cast<float>(origin[axes.normal] + slice + (axes.positive ? 1 : 0));
+        position[axes.col] = static_cast<float>(origin[axes.col] + col + a * width);
+        position[axes.row] = static_cast<float>(origin[axes.row] + row + b * height);
+        out.vertices.insert(out.vertices.end(), position, position + 3);
+
+        // UV 按合并的方块数平铺:沿某轴的 UV 从 0~1 放大为 0~该轴方块数
+        int uLocal = uAlongRow ? b : a;
+        int vLocal = uAlongRow ? a : b;
+        if (uFlip) uLocal = 1 - uLocal;
+        if (vFlip) vLocal = 1 - vLocal;
+        out.uvCoordinates.push_back(static_cast<float>(uLocal * (uAlongRow ? height : width)));
+        out.uvCoordinates.push_back(static_cast<float>(vLocal * (uAlongRow ? width : height)));
+
+        face.vertexIndices[j] = vertexBase + j;
+        face.uvIndices[j] = uvBase + j;
+    }
+    face.materialIndex = key >> 11;
+    constexpr FaceType kDirections[6] = {
+        FaceType::UP, FaceType::DOWN, FaceType::WEST, FaceType::EAST, FaceType::NORTH, FaceType::SOUTH
+    };
+    face.faceDirection = kDirections[dir];
+    out.faces.push_back(face);
+}
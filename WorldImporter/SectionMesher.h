@@ -0,0 +1,89 @@
+// SectionMesher.h
+#ifndef SECTION_MESHER_H
+#define SECTION_MESHER_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "model.h"
+#include "blockstate.h"
+#include "SectionVolume.h"
+
+// 全局材质编号:按材质名称去重,同一名称在整个导出过程中只有一个编号
+int InternMaterial(const Material& material);
+
+// 子区块网格生成器:逐方块查找共享的只读方块模型,只把未被剔除的面平移后直接追加到输出,
+// 材质按全局编号映射为输出中的下标,不再为每个方块构造、过滤和合并临时 ModelData
+//
+// 启用 useGreedyMesh 时,完整立方体方块(6 个面各占满一个方块面、贴图完整覆盖)的可见面
+// 先记录在每个方向、每层 16x16 的网格中,用 16 位行掩码在体素空间内贪心合并为大矩形,UV 按方块数平铺
+//
+// 每个线程使用一个实例(ThreadLocal),缓存与临时缓冲区在多次调用之间复用
+class SectionMesher {
+public:
+    static SectionMesher& ThreadLocal();
+
+    // 生成 volume 中心子区块内位于导出范围内的所有方块,追加到 out
+    void MeshSection(const SectionVolume& volume, ModelData& out);
+
+    // 开始向 out 逐个追加方块(MeshBlock),out 中已有的材质会被复用
+    void Begin(const ModelData& out);
+
+    // 生成单个方块,(x, y, z) 为中心子区块内的局部坐标;
+    // 两次调用之间 out 只能追加内容(例如合并 LOD 方块)
+    void MeshBlock(const SectionVolume& volume, int x, int y, int z, ModelData& out);
+
+private:
+    // 完整立方体的一个面:corners 依次存放 4 个顶点在面内的 (a, b) 角点(各 2 位),
+    // mapping 描述 UV 与面内坐标的对应:位 0 为 u 沿 b 轴(否则沿 a 轴),位 1/2 为 u/v 反向
+    struct CubeFace {
+        int materialIndex = 0;
+        uint8_t corners = 0;
+        uint8_t mapping = 0;
+    };
+
+    // 方块模型(不持有,指向模型缓存或临时存储)及其材质的全局编号(materialIds[i] 对应 model->materials[i])
+    struct BakedModel {
+        const ModelData* model = nullptr;
+        std::vector<int> materialIds;
+        bool fullCube = false;
+        std::array<CubeFace, 6> cubeFaces; // 按 neighborIsAir 的方向顺序
+    };
+
+    // 方块的模型,没有模型时返回 nullptr
+    // 候选模型通过 BlockTraits::model 句柄读取(每种方块状态全局只查询一次模型缓存),随机选择不加锁;
+    // 材质编号与立方体分析按模型地址缓存,每个模型每个线程只计算一次
+    const BakedModel* ModelForBlock(int blockId);
+    static void Bake(BakedModel& baked);
+
+    // 登记 out 中 boundMaterialCount 之后新增的材质
+    void SyncMaterials(const ModelData& out);
+    int OutputMaterial(const BakedModel& baked, int materialIndex, ModelData& out);
+
+    void MeshVoxel(const SectionVolume& volume, int x, int y, int z, ModelData& out);
+    void Emit(const BakedModel& baked, const std::array<bool, 6>& neighborIsAir, int worldX, int worldY, int worldZ, ModelData& out);
+
+    // 体素空间贪心合并
+    void RecordCubeFaces(const BakedModel& baked, const std::array<bool, 6>& neighborIsAir, int x, int y, int z, ModelData& out);
+    void MeshGreedyFaces(const SectionVolume& volume, ModelData& out);
+    void EmitGreedyQuad(const SectionVolume& volume, int dir, int slice, int col, int row, int width, int height, int key, ModelData& out);
+
+    std::unordered_map<const ModelData*, BakedModel> bakedModels;    // 缓存中的共享模型
+    ModelData scratchData;                                           // 流体模型的临时存储
+    BakedModel scratchModel;                                         // 指向 scratchData
+
+    std::vector<int> materialSlots;   // 全局材质编号 -> out.materials 下标,-1 表示尚未加入
+    std::vector<int> boundMaterials;  // materialSlots 中已设置的编号,用于快速重置
+    size_t boundMaterialCount = 0;    // out.materials 中已登记的数量
+    std::vector<int> vertexRemap;     // 模型顶点下标 -> out 顶点下标,-1 表示尚未输出
+    std::vector<int> uvRemap;         // 模型 UV 下标 -> out UV 下标
+
+    bool greedyActive = false;
+    // 待合并的面:[方向][层][行] 的列掩码,以及每格的合并键(输出材质、角点顺序与 UV 映射)
+    uint16_t greedyMasks[6][16][16] = {};
+    int greedyKeys[6][16][16][16] = {};
+};
+
+#endif // SECTION_MESHER_H
@@ -0,0 +1,192 @@
+// SectionStore.cpp
+#include "SectionStore.h"
+#include <algorithm>
+#include <bit>
+
+SectionStore::Column::~Column() {
+    for (auto& section : sections) {
+        delete section.load(std::memory_order_relaxed);
+    }
+}
+
+SectionStore::SectionStore() {
+    grid.store(new Grid(), std::memory_order_relaxed);
+    overflow.store(NewOverflowTable(16), std::memory_order_relaxed);
+}
+
+SectionStore::~SectionStore() {
+    Grid* g = grid.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < static_cast<size_t>(g->width) * g->depth; ++i) {
+        delete g->cells[i].load(std::memory_order_relaxed);
+    }
+    delete g;
+    OverflowTable* table = overflow.load(std::memory_order_relaxed);
+    for (size_t i = 0; i <= table->mask; ++i) {
+        delete table->slots[i].column.load(std::memory_order_relaxed);
+    }
+    delete table;
+    ReclaimRetired();
+}
+
+SectionStore::OverflowTable* SectionStore::NewOverflowTable(size_t capacity) {
+    OverflowTable* table = new OverflowTable();
+    table->mask = capacity - 1;
+    table->slots = std::make_unique<OverflowSlot[]>(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        table->slots[i].key.store(kEmptyKey, std::memory_order_relaxed);
+    }
+    return table;
+}
+
+void SectionStore::Reclaim() {
+    ReclaimRetired();
+}
+
+void SectionStore::ReclaimRetired() {
+    for (const SectionCacheEntry* section : retiredSections) delete section;
+    for (Column* column : retiredColumns) delete column;
+    for (Grid* g : retiredGrids) delete g;
+    for (OverflowTable* table : retiredTables) delete table;
+    retiredSections.clear();
+    retiredColumns.clear();
+    retiredGrids.clear();
+    retiredTables.clear();
+}
+
+void SectionStore::SetGrid(int chunkXStart, int chunkXEnd, int chunkZStart, int chunkZEnd) {
+    // 收集所有仍缓存的区块列,按新范围放入新网格或新哈希表
+    std::vector<std::pair<uint64_t, Column*>> columns;
+    Grid* oldGrid = grid.load(std::memory_order_relaxed);
+    for (int x = 0; x < oldGrid->width; ++x) {
+        for (int z = 0; z < oldGrid->depth; ++z) {
+            if (Column* column = oldGrid->cells[static_cast<size_t>(x) * oldGrid->depth + z].load(std::memory_order_relaxed)) {
+                columns.emplace_back(PackKey(oldGrid->xStart + x, oldGrid->zStart + z), column);
+            }
+        }
+    }
+    OverflowTable* oldTable = overflow.load(std::memory_order_relaxed);
+    for (size_t i = 0; i <= oldTable->mask; ++i) {
+        if (Column* column = oldTable->slots[i].column.load(std::memory_order_relaxed)) {
+            columns.emplace_back(oldTable->slots[i].key.load(std::memory_order_relaxed), column);
+        }
+    }
+
+    Grid* newGrid = new Grid();
+    newGrid->xStart = chunkXStart;
+    newGrid->zStart = chunkZStart;
+    newGrid->width = std::max(0, chunkXEnd - chunkXStart + 1);
+    newGrid->depth = std::max(0, chunkZEnd - chunkZStart + 1);
+    newGrid->cells = std::make_unique<std::atomic<Column*>[]>(static_cast<size_t>(newGrid->width) * newGrid->depth);
+    grid.store(newGrid, std::memory_order_release);
+    overflow.store(NewOverflowTable(16), std::memory_order_release);
+
+    for (const auto& [key, column] : columns) {
+        if (std::atomic<Column*>* cell = GridCell(UnpackX(key), UnpackZ(key))) {
+            cell->store(column, std::memory_order_release);
+        } else {
+            StoreOverflowColumn(UnpackX(key), UnpackZ(key), column);
+        }
+    }
+
+    // 批次之间没有读线程,此时释放上一批次中被替换或删除的对象
+    retiredGrids.push_back(oldGrid);
+    retiredTables.push_back(oldTable);
+    ReclaimRetired();
+}
+
+std::atomic<SectionStore::Column*>* SectionStore::GridCell(int chunkX, int chunkZ) {
+    Grid* g = grid.load(std::memory_order_relaxed);
+    unsigned x = static_cast<unsigned>(chunkX - g->xStart);
+    unsigned z = static_cast<unsigned>(chunkZ - g->zStart);
+    if (x < static_cast<unsigned>(g->width) && z < static_cast<unsigned>(g->depth)) {
+        return &g->cells[static_cast<size_t>(x) * g->depth + z];
+    }
+    return nullptr;
+}
+
+void SectionStore::StoreOverflowColumn(int chunkX, int chunkZ, Column* column) {
+    const uint64_t key = PackKey(chunkX, chunkZ);
+    OverflowTable* table = overflow.load(std::memory_order_relaxed);
+
+    // 负载超过一半时扩容:把仍有效的条目复制到新表后整体发布,旧表放入回收列表
+    if ((table->used + 1) * 2 > table->mask + 1) {
+        size_t live = 0;
+        for (size_t i = 0; i <= table->mask; ++i) {
+            if (table->slots[i].column.load(std::memory_order_relaxed)) ++live;
+        }
+        OverflowTable* grown = NewOverflowTable(std::bit_ceil(std::max<size_t>(16, (live + 1) * 4)));
+        for (size_t i = 0; i <= table->mask; ++i) {
+            Column* existing = table->slots[i].column.load(std::memory_order_relaxed);
+            if (!existing) continue;
+            uint64_t existingKey = table->slots[i].key.load(std::memory_order_relaxed);
+            size_t j = HashKey(existingKey) & grown->mask;
+            while (grown->slots[j].key.load(std::memory_order_relaxed) != kEmptyKey) {
+                j = (j + 1) & grown->mask;
+            }
+            grown->slots[j].column.store(existing, std::memory_order_relaxed);
+            grown->slots[j].key.store(existingKey, std::memory_order_relaxed);
+            ++grown->used;
+        }
+        overflow.store(grown, std::memory_order_release);
+        retiredTables.push_back(table);
+        table = grown;
+    }
+
+    for (size_t i = HashKey(key) & table->mask;; i = (i + 1) & table->mask) {
+        uint64_t slotKey = table->slots[i].key.load(std::memory_order_relaxed);
+        if (slotKey == key) {
+            table->slots[i].column.store(column, std::memory_order_release);
+            return;
+        }
+        if (slotKey == kEmptyKey) {
+            table->slots[i].column.store(column, std::memory_order_relaxed);
+            table->slots[i].key.store(key, std::memory_order_release);
+            ++table->used;
+            return;
+        }
+    }
+}
+
+SectionStore::Column& SectionStore::GetOrCreateColumn(int chunkX, int chunkZ) {
+    if (Column* column = FindColumnMutable(chunkX, chunkZ)) {
+        return *column;
+    }
+    Column* column = new Column();
+    if (std::atomic<Column*>* cell = GridCell(chunkX, chunkZ)) {
+        cell->store(column, std::memory_order_release);
+    } else {
+        StoreOverflowColumn(chunkX, chunkZ, column);
+    }
+    return *column;
+}
+
+void SectionStore::Insert(int chunkX, int chunkZ, int sectionY, SectionCacheEntry&& entry) {
+    if (sectionY < kMinSectionY || sectionY > kMaxSectionY) return;
+    Column& column = GetOrCreateColumn(chunkX, chunkZ);
+    const SectionCacheEntry* previous = column.sections[sectionY - kMinSectionY].exchange(
+        new SectionCacheEntry(std::move(entry)), std::memory_order_acq_rel);
+    if (previous) {
+        retiredSections.push_back(previous);
+    }
+}
+
+void SectionStore::EraseColumn(int chunkX, int chunkZ) {
+    Column* column = nullptr;
+    if (std::atomic<Column*>* cell = GridCell(chunkX, chunkZ)) {
+        column = cell->exchange(nullptr, std::memory_order_acq_rel);
+    } else {
+        const uint64_t key = PackKey(chunkX, chunkZ);
+        OverflowTable* table = overflow.load(std::memory_order_relaxed);
+        for (size_t i = HashKey(key) & table->mask;; i = (i + 1) & table->mask) {
+            uint64_t slotKey = table->slots[i].key.load(std::memory_order_relaxed);
+            if (slotKey == key) {
+                column = table->slots[i].column.exchange(nullptr, std::memory_order_acq_rel);
+                break;
+            }
+            if (slotKey == kEmptyKey) break;
+        }
+    }
+    if (column) {
+        retiredColumns.push_back(column);
+    }
+}
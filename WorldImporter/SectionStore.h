@@ -0,0 +1,177 @@
+// SectionStore.h
+#ifndef SECTION_STORE_H
+#define SECTION_STORE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "block.h"
+
+// 子区块缓存:按区块列(chunkX, chunkZ)组织,每列是按子区块 Y 直接寻址的指针数组
+//
+// 当前批次(含一圈边界)的区块列放在稠密二维网格中,查找只做算术寻址;
+// 网格外的区块列(例如生物群系混合时读取的远处区块)放在开放寻址哈希表中
+//
+// 读写方式为 RCU:
+// - 子区块在加载线程中完整构造后才以原子指针发布,发布后不再修改(替换时发布新条目);
+// - 网格与哈希表本身也通过原子指针发布,扩容或切换批次时整体替换;
+// - 被替换或删除的对象不立即释放,而是放入回收列表,在 SetGrid 或 Reclaim(批次之间,没有读线程)时释放
+// 因此 Find/IsLoaded 不需要任何锁,加载线程的写入也不会使读线程手中的指针失效
+// 写操作由调用者持有 sectionCacheMutex 写锁串行化
+class SectionStore {
+public:
+    // 缓存键中 Y 的范围:NBT 中子区块 Y 为 BYTE(-128~127),缓存中存放 AdjustSectionY 之后的值
+    static constexpr int kMinSectionY = -132;
+    static constexpr int kMaxSectionY = 127;
+    static constexpr int kColumnHeight = kMaxSectionY - kMinSectionY + 1;
+
+    struct Column {
+        std::array<std::atomic<const SectionCacheEntry*>, kColumnHeight> sections{};
+        std::atomic<bool> loaded{ false };                            // 区块已加载(包括读取失败的区块)
+        std::unordered_map<int, std::vector<char>> deferredSections;  // 尚未解码的子区块原始 NBT,键为缓存 Y(只在写锁内访问)
+        std::atomic<int> deferredCount{ 0 };                          // deferredSections 的数量(写锁内更新),查询时无锁检查
+
+        ~Column();
+    };
+
+    SectionStore();
+    ~SectionStore();
+
+    SectionStore(const SectionStore&) = delete;
+    SectionStore& operator=(const SectionStore&) = delete;
+
+    // 把稠密网格设为 [chunkXStart, chunkXEnd] × [chunkZStart, chunkZEnd],
+    // 已缓存的区块列按新范围在网格与哈希表之间移动,并释放回收列表中的对象;
+    // 只能在没有线程读取缓存时调用(批次之间)
+    void SetGrid(int chunkXStart, int chunkXEnd, int chunkZStart, int chunkZEnd);
+
+    // 释放回收列表中的对象(替换或删除的子区块、区块列、网格与哈希表)
+    // 只能在没有线程读取缓存时调用,例如批次卸载完成、网格生成线程结束之后
+    void Reclaim();
+
+    // 查找子区块(无锁),不存在时返回 nullptr;返回的指针至少在下一次 SetGrid 之前有效
+    const SectionCacheEntry* Find(int chunkX, int chunkZ, int sectionY) const {
+        if (sectionY < kMinSectionY || sectionY > kMaxSectionY) return nullptr;
+        const Column* column = FindColumn(chunkX, chunkZ);
+        return column ? column->sections[sectionY - kMinSectionY].load(std::memory_order_acquire) : nullptr;
+    }
+
+    bool IsLoaded(int chunkX, int chunkZ) const {
+        const Column* column = FindColumn(chunkX, chunkZ);
+        return column && column->loaded.load(std::memory_order_acquire);
+    }
+
+    // 以下写操作要求调用者持有 sectionCacheMutex 写锁
+    Column& GetOrCreateColumn(int chunkX, int chunkZ);
+    Column* FindColumnMutable(int chunkX, int chunkZ) { return const_cast<Column*>(FindColumn(chunkX, chunkZ)); }
+
+    // 发布子区块,已存在的条目被替换并放入回收列表;sectionY 超出范围时丢弃
+    void Insert(int chunkX, int chunkZ, int sectionY, SectionCacheEntry&& entry);
+
+    // 删除整个区块列(包括延迟解码的子区块),区块列放入回收列表
+    void EraseColumn(int chunkX, int chunkZ);
+
+    // 遍历所有已缓存的子区块:fn(chunkX, chunkZ, sectionY, const SectionCacheEntry&)
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        auto visit = [&](int chunkX, int chunkZ, const Column* column) {
+            if (!column) return;
+            for (int i = 0; i < kColumnHeight; ++i) {
+                if (const SectionCacheEntry* entry = column->sections[i].load(std::memory_order_acquire)) {
+                    fn(chunkX, chunkZ, kMinSectionY + i, *entry);
+                }
+            }
+        };
+        const Grid* g = grid.load(std::memory_order_acquire);
+        for (int x = 0; x < g->width; ++x) {
+            for (int z = 0; z < g->depth; ++z) {
+                visit(g->xStart + x, g->zStart + z, g->cells[static_cast<size_t>(x) * g->depth + z].load(std::memory_order_acquire));
+            }
+        }
+        const OverflowTable* table = overflow.load(std::memory_order_acquire);
+        for (size_t i = 0; i <= table->mask; ++i) {
+            uint64_t key = table->slots[i].key.load(std::memory_order_acquire);
+            if (key != kEmptyKey) {
+                visit(UnpackX(key), UnpackZ(key), table->slots[i].column.load(std::memory_order_acquire));
+            }
+        }
+    }
+
+private:
+    // 当前批次的稠密网格,下标 (chunkX - xStart) * depth + (chunkZ - zStart)
+    struct Grid {
+        int xStart = 0;
+        int zStart = 0;
+        int width = 0;
+        int depth = 0;
+        std::unique_ptr<std::atomic<Column*>[]> cells;
+    };
+
+    // 网格外区块列的开放寻址哈希表(线性探测)
+    // 写入先存列指针再存键,读线程看到键时列指针已经可见;删除只清空列指针,键保留到下次扩容
+    struct OverflowSlot {
+        std::atomic<uint64_t> key;
+        std::atomic<Column*> column{ nullptr };
+    };
+    struct OverflowTable {
+        size_t mask = 0;
+        size_t used = 0; // 已占用的槽位(含已删除)
+        std::unique_ptr<OverflowSlot[]> slots;
+    };
+
+    static constexpr uint64_t PackKey(int chunkX, int chunkZ) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(chunkX)) << 32) | static_cast<uint32_t>(chunkZ);
+    }
+    static constexpr int UnpackX(uint64_t key) { return static_cast<int>(static_cast<uint32_t>(key >> 32)); }
+    static constexpr int UnpackZ(uint64_t key) { return static_cast<int>(static_cast<uint32_t>(key)); }
+    // 空槽位的键,即 PackKey(INT_MIN, INT_MIN)
+    static constexpr uint64_t kEmptyKey = 0x8000000080000000ULL;
+
+    static size_t HashKey(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+
+    const Column* FindColumn(int chunkX, int chunkZ) const {
+        const Grid* g = grid.load(std::memory_order_acquire);
+        // 无符号比较同时排除了小于起点的坐标
+        unsigned x = static_cast<unsigned>(chunkX - g->xStart);
+        unsigned z = static_cast<unsigned>(chunkZ - g->zStart);
+        if (x < static_cast<unsigned>(g->width) && z < static_cast<unsigned>(g->depth)) {
+            return g->cells[static_cast<size_t>(x) * g->depth + z].load(std::memory_order_acquire);
+        }
+        return FindOverflowColumn(PackKey(chunkX, chunkZ));
+    }
+
+    const Column* FindOverflowColumn(uint64_t key) const {
+        const OverflowTable* table = overflow.load(std::memory_order_acquire);
+        for (size_t i = HashKey(key) & table->mask;; i = (i + 1) & table->mask) {
+            uint64_t slotKey = table->slots[i].key.load(std::memory_order_acquire);
+            if (slotKey == key) return table->slots[i].column.load(std::memory_order_acquire);
+            if (slotKey == kEmptyKey) return nullptr;
+        }
+    }
+
+    std::atomic<Column*>* GridCell(int chunkX, int chunkZ);
+    void StoreOverflowColumn(int chunkX, int chunkZ, Column* column);
+    static OverflowTable* NewOverflowTable(size_t capacity);
+    void ReclaimRetired();
+
+    std::atomic<Grid*> grid;
+    std::atomic<OverflowTable*> overflow;
+
+    // 等待回收的对象,在 SetGrid、Reclaim 与析构时释放
+    std::vector<Column*> retiredColumns;
+    std::vector<const SectionCacheEntry*> retiredSections;
+    std::vector<Grid*> retiredGrids;
+    std::vector<OverflowTable*> retiredTables;
+};
+
+extern SectionStore sectionCache;
+
+#endif // SECTION_STORE_H
@@ -0,0 +1,141 @@
+// SectionVolume.cpp
+#include "SectionVolume.h"
+#include "SectionStore.h"
+#include "locutil.h"
+#include <algorithm>
+
+// 复制子区块中从 yzx 开始的一行 count 个方块的方块ID与天空光照,子区块不存在时填 0
+static void CopyRow(const SectionCacheEntry* section, int yzx, int count, int* outIds, int8_t* outSkyLight) {
+    if (!section) {
+        std::fill_n(outIds, count, 0);
+        std::fill_n(outSkyLight, count, int8_t(0));
+        return;
+    }
+    if (!section->blockIndices.empty()) {
+        const uint8_t* indices = section->blockIndices.data() + yzx;
+        for (int i = 0; i < count; ++i) outIds[i] = section->blockPalette[indices[i]];
+    } else if (!section->wideBlockIndices.empty()) {
+        const uint16_t* indices = section->wideBlockIndices.data() + yzx;
+        for (int i = 0; i < count; ++i) outIds[i] = section->blockPalette[indices[i]];
+    } else {
+        std::fill_n(outIds, count, section->uniformBlock);
+    }
+    for (int i = 0; i < count; ++i) {
+        outSkyLight[i] = static_cast<int8_t>(section->skyLight.Get(yzx + i));
+    }
+}
+
+void SectionVolume::Gather(int chunkX, int sectionY, int chunkZ) {
+    originX = chunkX * 16;
+    originY = sectionY * 16;
+    originZ = chunkZ * 16;
+
+    // 每个方向上 -1、0、1 三段分别对应相邻子区块中的局部坐标范围(含两端)
+    static constexpr int kBegin[3] = { -1, 0, 16 };
+    static constexpr int kEnd[3] = { -1, 15, 16 };
+
+    // 按相邻子区块逐块复制,每个子区块只查找一次
+    for (int sy = 0; sy < 3; ++sy) {
+        // 上方子区块多复制一层(y = 17),供流体等级检查上方方块
+        int yEnd = (sy == 2) ? 17 : kEnd[sy];
+        for (int sz = 0; sz < 3; ++sz) {
+            for (int sx = 0; sx < 3; ++sx) {
+                const SectionCacheEntry* section = sectionCache.Find(chunkX + sx - 1, chunkZ + sz - 1, AdjustSectionY(sectionY + sy - 1));
+                int count = kEnd[sx] - kBegin[sx] + 1;
+                for (int y = kBegin[sy]; y <= yEnd; ++y) {
+                    for (int z = kBegin[sz]; z <= kEnd[sz]; ++z) {
+                        int index = Index(kBegin[sx], y, z);
+                        int yzx = ((y & 15) << 8) | ((z & 15) << 4) | (kBegin[sx] & 15);
+                        CopyRow(section, yzx, count, blockIds.data() + index, skyLight.data() + index);
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < blockIds.size(); ++i) {
+        flags[i] = GetBlockFlags(blockIds[i]);
+    }
+
+    // 流体等级(同 GetLevel):注册流体或 level 为 0 时检查上方方块
+    const int layer = kSize * kSize;
+    for (size_t i = 0; i + layer < blockIds.size(); ++i) {
+        uint8_t f = flags[i];
+        if (f & (BLOCK_FLAG_FLUID | BLOCK_FLAG_WATERLOGGED)) {
+            uint8_t upper = flags[i + layer];
+            levels[i] = (upper & (BLOCK_FLAG_FLUID | BLOCK_FLAG_WATERLOGGED)) ? 8 : GetBlockTraits(blockIds[i]).level;
+        } else {
+            levels[i] = (f & BLOCK_FLAG_OPAQUE) ? -2 : -1;
+        }
+    }
+}
+
+int SectionVolume::BlockIdWithNeighbors(int x, int y, int z, bool* neighborIsAir, int* fluidLevels) const {
+    int currentId = BlockId(x, y, z);
+    bool hasFluidData = (Flags(x, y, z) & BLOCK_FLAG_HAS_FLUID) != 0;
+
+    // 统一处理 neighborIsAir 数组(6个方向)
+    if (neighborIsAir != nullptr) {
+        static constexpr int directions[6][3] = {
+            {0, 1, 0},    // 上(Y+)
+            {0, -1, 0},   // 下(Y-)
+            {-1, 0, 0},   // 西(X-)
+            {1, 0, 0},    // 东(X+)
+            {0, 0, -1},   // 北(Z-)
+            {0, 0, 1}     // 南(Z+)
+        };
+
+        if (!hasFluidData) {
+            // 非流体方块:邻居是否遮挡只取决于不透明位
+            for (int i = 0; i < 6; ++i) {
+                neighborIsAir[i] = !(Flags(x + directions[i][0], y + directions[i][1], z + directions[i][2]) & BLOCK_FLAG_OPAQUE);
+            }
+        }
+        else {
+            int currentBaseId = GetBlockTraits(currentId).baseId;
+            for (int i = 0; i < 6; ++i) {
+                int nx = x + directions[i][0], ny = y + directions[i][1], nz = z + directions[i][2];
+                uint8_t neighborFlags = Flags(nx, ny, nz);
+
+                // 邻居为同种流体且不是源/含水(level 非 0 非 -1),或邻居为非流体的非实心方块
+                bool flowingNeighbor = (neighborFlags & (BLOCK_FLAG_HAS_FLUID | BLOCK_FLAG_WATERLOGGED)) == BLOCK_FLAG_HAS_FLUID;
+                bool openNeighbor = (neighborFlags & (BLOCK_FLAG_WATERLOGGED | BLOCK_FLAG_FLUID | BLOCK_FLAG_OPAQUE)) == 0;
+                neighborIsAir[i] = (flowingNeighbor && GetBlockTraits(BlockId(nx, ny, nz)).baseId == currentBaseId) || openNeighbor;
+            }
+        }
+
+        // 如果启用了保留边界面,则直接判断
+        if (config.keepBoundary) {
+            for (int i = 0; i < 6; ++i) {
+                int nx = originX + x + directions[i][0];
+                int nz = originZ + z + directions[i][2];
+                if ((nx == config.maxX + 1) || (nx == config.minX - 1) ||
+                    (nz == config.maxZ + 1) || (nz == config.minZ - 1)) {
+                    neighborIsAir[i] = true;
+                }
+            }
+        }
+    }
+
+    // 处理 fluidLevels 数组,仅在存在流体数据且数组不为空时进行
+    if (hasFluidData && fluidLevels != nullptr) {
+        // 中心块的流体等级
+        fluidLevels[0] = Level(x, y, z);
+        static constexpr int levelDirections[9][3] = {
+            {0, 0, -1},   // 北
+            {0, 0, 1},    // 南
+            {1, 0, 0},    // 东
+            {-1, 0, 0},   // 西
+            {1, 0, -1},   // 东北
+            {-1, 0, -1},  // 西北
+            {1, 0, 1},    // 东南
+            {-1, 0, 1},   // 西南
+            {0, 1, 0}     // 上
+        };
+        for (int i = 0; i < 9; ++i) {
+            fluidLevels[i + 1] = Level(x + levelDirections[i][0], y + levelDirections[i][1], z + levelDirections[i][2]);
+        }
+    }
+
+    return currentId;
+}
@@ -0,0 +1,56 @@
+// SectionVolume.h
+#ifndef SECTION_VOLUME_H
+#define SECTION_VOLUME_H
+
+#include <array>
+#include <cstdint>
+
+// 网格生成用的带边界体素:中心子区块 16x16x16 加四周各一格(18x18x18),
+// Y 方向再多一层(y = 17),使 y = 16 处的流体等级也能检查上方方块
+//
+// Gather 一次性从 sectionCache 收集中心与相邻共 27 个子区块的数据,
+// 之后的方块ID、天空光照、流体等级与邻居查询都只访问本对象中的数组
+// 坐标均为相对中心子区块的局部坐标,x/z 取值 -1~16,y 取值 -1~16(方块ID可到 17)
+class SectionVolume {
+public:
+    static constexpr int kSize = 18;
+    static constexpr int kHeight = 19;
+
+    // 收集 (chunkX, sectionY, chunkZ) 子区块及其邻居,sectionY 为世界子区块 Y(方块Y / 16)
+    void Gather(int chunkX, int sectionY, int chunkZ);
+
+    // 局部坐标 (0,0,0) 对应的世界方块坐标
+    int OriginX() const { return originX; }
+    int OriginY() const { return originY; }
+    int OriginZ() const { return originZ; }
+
+    // 同 GetBlockId,未加载的子区块为空气(0)
+    int BlockId(int x, int y, int z) const { return blockIds[Index(x, y, z)]; }
+
+    // 同 GetBlockFlags(BlockId(x, y, z))
+    uint8_t Flags(int x, int y, int z) const { return flags[Index(x, y, z)]; }
+
+    // 同 GetSkyLight:未加载的子区块为 0,没有光照数据时为标记 -1/-2
+    int SkyLight(int x, int y, int z) const { return skyLight[Index(x, y, z)]; }
+
+    // 同 GetLevel:流体等级,上方为流体时为 8,空气为 -1,固体为 -2
+    int Level(int x, int y, int z) const { return levels[Index(x, y, z)]; }
+
+    // 同 GetBlockIdWithNeighbors,只能用于中心子区块内的坐标(0~15)
+    int BlockIdWithNeighbors(int x, int y, int z, bool* neighborIsAir = nullptr, int* fluidLevels = nullptr) const;
+
+private:
+    static constexpr int Index(int x, int y, int z) {
+        return ((y + 1) * kSize + (z + 1)) * kSize + (x + 1);
+    }
+
+    int originX = 0;
+    int originY = 0;
+    int originZ = 0;
+    std::array<int, kSize * kSize * kHeight> blockIds{};
+    std::array<uint8_t, kSize * kSize * kHeight> flags{};
+    std::array<int8_t, kSize * kSize * kHeight> skyLight{};
+    std::array<int8_t, kSize * kSize * kHeight> levels{}; // 最上一层(y = 17)不计算
+};
+
+#endif // SECTION_VOLUME_H
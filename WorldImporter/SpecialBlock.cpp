@@ -221,12 +221,11 @@ ModelData SpecialBlock::GenerateBedModel(const string& blockName) {
 
     // 构建材质路径
     string textureName = ns + ":entity/bed/" + color;
-    string textureFileDir = "textures";
-    string savedTexturePath;
-    if (!SaveTextureToFile(ns, "entity/bed/" + color, textureFileDir)) {
+    // 同色的床有多个方块状态,可能在不同线程中同时烘焙:纹理只保存一次
+    if (!SaveTextureOnce(ns, "entity/bed/" + color)) {
         return ModelData(); // 纹理不存在,返回空模型
     }
-    savedTexturePath = "textures/" + ns + "/entity/bed/" + color + ".png";
+    string savedTexturePath = "textures/" + ns + "/entity/bed/" + color + ".png";
     RegisterTexture(ns, "entity/bed/" + color, savedTexturePath);
 
     ModelData model;
@@ -0,0 +1,135 @@
+// ThreadPool.cpp
+#include "ThreadPool.h"
+#include "config.h"
+
+// 当前线程在所属线程池中的队列下标,非池内线程为 SIZE_MAX
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorker = SIZE_MAX;
+
+ThreadPool& ThreadPool::Loader() {
+    static ThreadPool pool([] {
+        size_t count = config.loaderThreads > 0 ? static_cast<size_t>(config.loaderThreads) : std::thread::hardware_concurrency();
+        return count > 0 ? count : size_t(4);
+    }());
+    return pool;
+}
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0) threadCount = 1;
+    queues.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void ThreadPool::Submit(Task task) {
+    // 池内线程提交到自己的队列,外部线程轮流分配
+    size_t index = (currentPool == this) ? currentWorker : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    // 先计数再入队:TryPop 取出任务后才减少计数,计数不会短暂低于 0
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        pendingTasks.fetch_add(1, std::memory_order_release);
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    wakeCondition.notify_one();
+}
+
+bool ThreadPool::TryPop(size_t preferred, Task& task) {
+    if (preferred < queues.size()) {
+        WorkerQueue& own = *queues[preferred];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            pendingTasks.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+    size_t start = (preferred < queues.size()) ? preferred + 1 : 0;
+    for (size_t i = 0; i < queues.size(); ++i) {
+        WorkerQueue& victim = *queues[(start + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pendingTasks.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+    while (true) {
+        Task task;
+        if (TryPop(index, task)) {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCondition.wait(lock, [this] {
+            return stopping || pendingTasks.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping && pendingTasks.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+
+    // 完成状态由各任务共享持有:调用者看到计数归零后可能立即返回,
+    // 最后一个任务随后加锁通知时仍不能访问调用者栈上的对象
+    struct Completion {
+        std::atomic<size_t> remaining;
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+    auto done = std::make_shared<Completion>();
+    done->remaining.store(count, std::memory_order_relaxed);
+
+    for (size_t i = 0; i < count; ++i) {
+        Submit([&fn, done, i] {
+            fn(i);
+            std::lock_guard<std::mutex> lock(done->mutex);
+            if (done->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                done->condition.notify_all();
+            }
+        });
+    }
+
+    // 等待期间帮助执行任务,避免池内嵌套调用时死锁
+    size_t self = (currentPool == this) ? currentWorker : SIZE_MAX;
+    while (done->remaining.load(std::memory_order_acquire) > 0) {
+        Task task;
+        if (TryPop(self, task)) {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(done->mutex);
+        done->condition.wait_for(lock, std::chrono::milliseconds(1), [&] {
+            return done->remaining.load(std::memory_order_acquire) == 0;
+        });
+    }
+}
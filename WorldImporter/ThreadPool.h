@@ -0,0 +1,58 @@
+// ThreadPool.h
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 固定大小的工作窃取线程池
+// 每个工作线程拥有自己的任务队列:从队尾取自己的任务,空闲时从其他线程队首窃取
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    // 全局加载线程池,线程数由 config.loaderThreads 决定(0 为 CPU 核心数)
+    static ThreadPool& Loader();
+
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t Size() const { return workers.size(); }
+
+    // 并行执行 fn(0..count-1) 并等待全部完成
+    // 等待期间调用线程也会执行队列中的任务,因此可在池内线程中嵌套调用
+    void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void Submit(Task task);
+    void WorkerLoop(size_t index);
+    // 取出一个任务:优先本线程队列,否则从其他队列窃取
+    bool TryPop(size_t preferred, Task& task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> nextQueue{ 0 };
+    std::atomic<size_t> pendingTasks{ 0 };
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    bool stopping = false;
+};
+
+#endif // THREAD_POOL_H
@@ -4,6 +4,7 @@
 #include "include/stb_image.h"
 #include "biome.h"
 #include "block.h"
+#include "SectionStore.h"
 #include "GlobalCache.h"
 #include "locutil.h"
 #include <iostream>
@@ -138,15 +139,16 @@ int GetBiomeId(int blockX, int blockY, int blockZ) {
     int sectionY;
     blockYToSectionY(blockY, sectionY);
 
-    // 创建缓存键
-    auto blockKey = std::make_tuple(chunkX, chunkZ, sectionY);
-
     // 检查 SectionCache 中是否存在对应的区块数据,如果没有则加载
-    if (sectionCache.find(blockKey) == sectionCache.end()) {
+    const SectionCacheEntry* section = sectionCache.Find(chunkX, chunkZ, sectionY);
+    if (!section) {
         LoadAndCacheBlockData(chunkX, chunkZ);
+        LoadDeferredSection(chunkX, chunkZ, sectionY);
+        section = sectionCache.Find(chunkX, chunkZ, sectionY);
+    }
+    if (!section) {
+        return 0;
     }
-
-    const auto& biomeData = sectionCache[blockKey].biomeData;
 
     int biomeX = mod16(blockX) / 4;
     int biomeY = mod16(blockY) / 4;
@@ -156,7 +158,7 @@ int GetBiomeId(int blockX, int blockY, int blockZ) {
     int index = 16 * biomeY + 4 * biomeZ + biomeX;
 
     // 获取并返回群系ID
-    return (index < biomeData.size()) ? biomeData[index] : 0;
+    return section->BiomeAt(index);
 }
 
 // 初始化静态成员
@@ -404,16 +406,14 @@ int Biome::GetBiomeColor(int blockX, int blockY, int blockZ, BiomeColorType colo
             int sectionY;
             blockYToSectionY(blockY, sectionY);
 
-            // 创建缓存键
-            auto blockKey = std::make_tuple(chunkX, chunkZ, sectionY);
-
             // 检查 SectionCache 中是否存在对应的区块数据,否则加载
-            if (sectionCache.find(blockKey) == sectionCache.end()) {
+            const SectionCacheEntry* section = sectionCache.Find(chunkX, chunkZ, sectionY);
+            if (!section) {
                 LoadAndCacheBlockData(chunkX, chunkZ);
+                LoadDeferredSection(chunkX, chunkZ, sectionY);
+                section = sectionCache.Find(chunkX, chunkZ, sectionY);
             }
 
-            const auto& biomeData = sectionCache[blockKey].biomeData;
-
             // 计算在子区块内的坐标,注意与生物群系数据排列有关
             int biomeX = mod16(curX) / 4;
             int biomeY = mod16(blockY) / 4;
@@ -421,7 +421,7 @@ int Biome::GetBiomeColor(int blockX, int blockY, int blockZ, BiomeColorType colo
             int index = 16 * biomeY + 4 * biomeZ + biomeX;
 
             // 获取生物群系ID(若超出范围,则默认为0)
-            int biomeId = (index < biomeData.size()) ? biomeData[index] : 0;
+            int biomeId = section ? section->BiomeAt(index) : 0;
 
             // 共享读锁确保 biomeRegistry 的线程安全
             std::shared_lock<std::shared_mutex> lock(registryMutex);
@@ -0,0 +1,202 @@
+#include "bitutils.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BITUTILS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define BITUTILS_TARGET(isa)
+#else
+#define BITUTILS_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+// 读取一个大端序 long(主机为小端序)
+static inline uint64_t LoadBigEndian64(const char* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+#ifdef _MSC_VER
+    return _byteswap_uint64(value);
+#else
+    return __builtin_bswap64(value);
+#endif
+}
+
+// --------------------------------------------------------------------------------
+// 标量内核
+// --------------------------------------------------------------------------------
+// 最后一个不完整的 long 以及运行时位宽的通用实现
+static size_t UnpackGeneric(const char* src, size_t numLongs, size_t longIndex, int bits, int* out, size_t written, size_t count) {
+    const int perLong = 64 / bits;
+    const uint64_t mask = (bits >= 64) ? ~0ULL : ((1ULL << bits) - 1);
+    for (; longIndex < numLongs && written < count; ++longIndex) {
+        uint64_t value = LoadBigEndian64(src + longIndex * 8);
+        for (int j = 0; j < perLong && written < count; ++j) {
+            out[written++] = static_cast<int>((value >> (j * bits)) & mask);
+        }
+    }
+    return written;
+}
+
+// 位宽在编译期确定:每个 long 的条目数、移位量和掩码都是常量,内层循环可完全展开
+template <int Bits>
+static size_t UnpackScalar(const char* src, size_t numLongs, int* out, size_t count) {
+    constexpr int kPerLong = 64 / Bits;
+    constexpr uint64_t kMask = (1ULL << Bits) - 1;
+    size_t written = 0;
+    size_t i = 0;
+    for (; i < numLongs && written + kPerLong <= count; ++i) {
+        uint64_t value = LoadBigEndian64(src + i * 8);
+        for (int j = 0; j < kPerLong; ++j) {
+            out[written + j] = static_cast<int>((value >> (j * Bits)) & kMask);
+        }
+        written += kPerLong;
+    }
+    return UnpackGeneric(src, numLongs, i, Bits, out, written, count);
+}
+
+#ifdef BITUTILS_X86
+// --------------------------------------------------------------------------------
+// SIMD 内核
+// --------------------------------------------------------------------------------
+struct CpuFeatures {
+    bool sse41 = false;
+    bool avx2 = false;
+};
+
+static CpuFeatures DetectCpuFeatures() {
+    CpuFeatures features;
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    features.sse41 = (info[2] & (1 << 19)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        features.avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    features.sse41 = __builtin_cpu_supports("sse4.1");
+    features.avx2 = __builtin_cpu_supports("avx2");
+#endif
+    return features;
+}
+
+static const CpuFeatures& GetCpuFeatures() {
+    static const CpuFeatures features = DetectCpuFeatures();
+    return features;
+}
+
+// 4 位条目(调色板不超过 16 种方块,最常见的情况):每次处理 2 个 long
+// 先按 long 翻转字节得到小端序,每个字节的低/高半字节依次是相邻的两个条目
+BITUTILS_TARGET("sse4.1")
+static size_t UnpackNibblesSse41(const char* src, size_t numLongs, int* out, size_t count) {
+    const __m128i reverse = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    const __m128i lowNibble = _mm_set1_epi8(0x0F);
+    size_t written = 0;
+    size_t i = 0;
+    for (; i + 2 <= numLongs && written + 32 <= count; i += 2) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 8));
+        __m128i bytes = _mm_shuffle_epi8(raw, reverse);
+        __m128i lo = _mm_and_si128(bytes, lowNibble);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), lowNibble);
+        __m128i entries[2] = { _mm_unpacklo_epi8(lo, hi), _mm_unpackhi_epi8(lo, hi) };
+        for (const __m128i& e : entries) {
+            __m128i* dst = reinterpret_cast<__m128i*>(out + written);
+            _mm_storeu_si128(dst + 0, _mm_cvtepu8_epi32(e));
+            _mm_storeu_si128(dst + 1, _mm_cvtepu8_epi32(_mm_srli_si128(e, 4)));
+            _mm_storeu_si128(dst + 2, _mm_cvtepu8_epi32(_mm_srli_si128(e, 8)));
+            _mm_storeu_si128(dst + 3, _mm_cvtepu8_epi32(_mm_srli_si128(e, 12)));
+            written += 16;
+        }
+    }
+    return UnpackGeneric(src, numLongs, i, 4, out, written, count);
+}
+
+// 通用位宽:把一个 long 广播到 4 个通道,用变量移位一次取出 4 个条目,再压缩为 4 个 int
+template <int Bits>
+BITUTILS_TARGET("avx2")
+static size_t UnpackAvx2(const char* src, size_t numLongs, int* out, size_t count) {
+    constexpr int kPerLong = 64 / Bits;
+    constexpr int kGroups = kPerLong / 4;
+    constexpr uint64_t kMask = (1ULL << Bits) - 1;
+
+    const __m256i mask = _mm256_set1_epi64x(static_cast<long long>(kMask));
+    const __m256i packLow = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    __m256i shifts[kGroups];
+    for (int g = 0; g < kGroups; ++g) {
+        shifts[g] = _mm256_setr_epi64x((4 * g + 0) * Bits, (4 * g + 1) * Bits, (4 * g + 2) * Bits, (4 * g + 3) * Bits);
+    }
+
+    size_t written = 0;
+    size_t i = 0;
+    for (; i < numLongs && written + kPerLong <= count; ++i) {
+        uint64_t value = LoadBigEndian64(src + i * 8);
+        __m256i v = _mm256_set1_epi64x(static_cast<long long>(value));
+        for (int g = 0; g < kGroups; ++g) {
+            __m256i e = _mm256_and_si256(_mm256_srlv_epi64(v, shifts[g]), mask);
+            e = _mm256_permutevar8x32_epi32(e, packLow);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + written + 4 * g), _mm256_castsi256_si128(e));
+        }
+        for (int j = kGroups * 4; j < kPerLong; ++j) {
+            out[written + j] = static_cast<int>((value >> (j * Bits)) & kMask);
+        }
+        written += kPerLong;
+    }
+    return UnpackGeneric(src, numLongs, i, Bits, out, written, count);
+}
+#endif
+
+// --------------------------------------------------------------------------------
+// 分派
+// --------------------------------------------------------------------------------
+using UnpackKernel = size_t(*)(const char*, size_t, int*, size_t);
+
+template <int... Bits>
+static constexpr std::array<UnpackKernel, sizeof...(Bits) + 1> MakeScalarKernels(std::integer_sequence<int, Bits...>) {
+    return { nullptr, &UnpackScalar<Bits + 1>... };
+}
+
+#ifdef BITUTILS_X86
+template <int... Bits>
+static constexpr std::array<UnpackKernel, sizeof...(Bits) + 1> MakeAvx2Kernels(std::integer_sequence<int, Bits...>) {
+    return { nullptr, &UnpackAvx2<Bits + 1>... };
+}
+#endif
+
+// 按位宽(1~16)索引的内核表,首次调用时根据 CPU 特性选定
+static const std::array<UnpackKernel, 17>& GetKernels() {
+    static const std::array<UnpackKernel, 17> kernels = [] {
+        std::array<UnpackKernel, 17> table = MakeScalarKernels(std::make_integer_sequence<int, 16>());
+#ifdef BITUTILS_X86
+        const CpuFeatures& cpu = GetCpuFeatures();
+        if (cpu.avx2) {
+            table = MakeAvx2Kernels(std::make_integer_sequence<int, 16>());
+        }
+        if (cpu.sse41) {
+            table[4] = &UnpackNibblesSse41;
+        }
+#endif
+        return table;
+    }();
+    return kernels;
+}
+
+size_t UnpackPackedLongs(std::span<const char> packed, int bitsPerEntry, int* out, size_t count) {
+    size_t numLongs = packed.size() / 8;
+    if (bitsPerEntry <= 0 || numLongs == 0 || count == 0) {
+        return 0;
+    }
+    if (bitsPerEntry > 16) {
+        return UnpackGeneric(packed.data(), numLongs, 0, bitsPerEntry, out, 0, count);
+    }
+    return GetKernels()[bitsPerEntry](packed.data(), numLongs, out, count);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+// 解包 Minecraft 1.16+ 的紧凑长整型数组(block_states、biomes、Heightmaps 的 data)
+// 每个 long 存放 64 / bitsPerEntry 个条目,条目不跨越 long 边界,低位在前
+// packed 为 NBT 中 LONG_ARRAY 的原始大端字节,直接解包到 out,不生成中间数组
+// 最多写入 count 个条目,返回实际写入的条目数(数据不足时小于 count,其余位置保持不变)
+//
+// bitsPerEntry 为 1~16 时使用按位宽特化的内核;x86 上运行时检测 CPU,
+// 4 位条目使用 SSE4.1 字节拆分,其余位宽使用 AVX2 变量移位,均不支持时使用标量内核
+size_t UnpackPackedLongs(std::span<const char> packed, int bitsPerEntry, int* out, size_t count);
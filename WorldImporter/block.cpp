@@ -1,11 +1,14 @@
 ﻿// --- C++ 标准库头文件 ---
 #include <algorithm>
+#include <cstring>
 #include <array>
+#include <bit>
 #include <chrono>
 #include <fstream>
 #include <iostream>
 #include <locale>
 #include <random>
+#include <span>
 #include <sstream>
 #include <string>
 #include <unordered_map>
@@ -17,16 +20,20 @@
 // --- 项目头文件 ---
 #include "config.h"
 #include "block.h"
+#include "BlockRegistry.h"
 #include "RegionCache.h"
 #include "model.h"
 #include "EntityBlock.h"
 #include "blockstate.h"
 #include "nbtutils.h"
+#include "nbtview.h"
 #include "biome.h"
 #include "fileutils.h"
 #include "decompressor.h"
 #include "locutil.h"
 #include "hashutils.h"
+#include "bitutils.h"
+#include "SectionStore.h"
 
 using namespace std;
 
@@ -39,7 +46,7 @@ using namespace std;
 // 带读写锁的区块缓存
 std::shared_mutex sectionCacheMutex;
 std::shared_mutex chunkAuxCacheMutex;
-std::unordered_map<std::tuple<int, int, int>, SectionCacheEntry, triple_hash> sectionCache(4096);
+SectionStore sectionCache;
 
 // 为 EntityBlockCache 和 heightMapCache 定义新的互斥锁
 std::shared_mutex entityBlockCacheMutex;
@@ -49,8 +56,6 @@ std::shared_mutex heightMapCacheMutex;
 std::unordered_map<std::pair<int, int>, std::vector<std::shared_ptr<EntityBlock>>, pair_hash> EntityBlockCache(1024);
 std::unordered_map<std::pair<int, int>, std::unordered_map<std::string, std::vector<int>>, pair_hash> heightMapCache(1024);
 
-std::vector<Block> globalBlockPalette;
-
 
 // 添加静态邻居偏移数组,避免重复构造
 static const std::array<std::tuple<int, int, int>, 6> kSectionNeighborOffsets = { {
@@ -63,33 +68,26 @@ static const std::array<std::tuple<int, int, int>, 6> kSectionNeighborOffsets =
 // 文件操作相关函数
 // --------------------------------------------------------------------------------
 void UpdateSkyLightNeighborFlags() {
-    std::unordered_map<std::tuple<int, int, int>, bool, triple_hash> needsUpdate;
+    std::vector<std::tuple<int, int, int>> needsUpdate;
 
     {
         std::shared_lock<std::shared_mutex> readLock(sectionCacheMutex);
         // 收集需要更新的区块
-        for (const auto& entry : sectionCache) {
-            const auto& key = entry.first;
-            const auto& skyLightData = entry.second.skyLight;
-
-            if (skyLightData.size() == 1 && skyLightData[0] == -1) {
-                needsUpdate[key] = true;
+        sectionCache.ForEach([&](int chunkX, int chunkZ, int sectionY, const SectionCacheEntry& entry) {
+            if (!entry.skyLight.HasData() && entry.skyLight.value == -1) {
+                needsUpdate.emplace_back(chunkX, chunkZ, sectionY);
             }
-        }
+        });
     }
 
-    // 检查邻居,并更新skyLightData为单元素-2
-    for (auto& entry : needsUpdate) {
-        int chunkX = std::get<0>(entry.first);
-        int chunkZ = std::get<1>(entry.first);
-        int sectionY = std::get<2>(entry.first);
+    // 检查邻居,并把没有天空光照数据的标记改为-2
+    for (const auto& [chunkX, chunkZ, sectionY] : needsUpdate) {
         bool hasLightNeighbor = false;
         {
             std::shared_lock<std::shared_mutex> readLock(sectionCacheMutex);
             for (const auto& offset : kSectionNeighborOffsets) {
-                auto dir = std::make_tuple(chunkX + std::get<0>(offset), chunkZ + std::get<1>(offset), sectionY + std::get<2>(offset));
-                auto it = sectionCache.find(dir);
-                if (it != sectionCache.end() && it->second.skyLight.size() == 4096) {
+                const SectionCacheEntry* neighbor = sectionCache.Find(chunkX + std::get<0>(offset), chunkZ + std::get<1>(offset), sectionY + std::get<2>(offset));
+                if (neighbor && neighbor->skyLight.HasData()) {
                     hasLightNeighbor = true;
                     break;
                 }
@@ -97,8 +95,12 @@ void UpdateSkyLightNeighborFlags() {
         }
         if (hasLightNeighbor) {
             std::unique_lock<std::shared_mutex> writeLock(sectionCacheMutex);
-            auto& skyLightData = sectionCache[entry.first].skyLight;
-            skyLightData.assign(1, -2);
+            // 已发布的子区块不可修改,复制后发布新条目
+            if (const SectionCacheEntry* section = sectionCache.Find(chunkX, chunkZ, sectionY)) {
+                SectionCacheEntry updated = *section;
+                updated.skyLight.value = -2;
+                sectionCache.Insert(chunkX, chunkZ, sectionY, std::move(updated));
+            }
         }
     }
 }
@@ -106,200 +108,214 @@ void UpdateSkyLightNeighborFlags() {
 // --------------------------------------------------------------------------------
 // 方块相关核心函数
 // --------------------------------------------------------------------------------
-// 新增函数:处理单个子区块
-void ProcessSection(int chunkX, int chunkZ, int sectionY, const NbtTagPtr& sectionTag) {
-    std::vector<std::string> blockPalette;
-    std::vector<int> blockData;
-    try {
-    // 获取方块数据
-    auto blo = getBlockStates(sectionTag);
-    blockPalette = getBlockPalette(blo);
-    blockData = getBlockStatesData(blo, blockPalette);
-
-    // 转换为全局ID并注册调色板
-    std::vector<int> globalBlockData;
-    globalBlockData.reserve(blockData.size()); // 预分配空间
-
-    static std::unordered_map<std::string, int> globalBlockMap; // 预处理全局调色板映射
-
-    // 预处理全局调色板,建立快速查找的映射
-    if (globalBlockMap.empty()) {
-        for (size_t i = 0; i < globalBlockPalette.size(); ++i) {
-            const Block& block = globalBlockPalette[i];
-            if (globalBlockMap.find(block.name) == globalBlockMap.end()) {
-                globalBlockMap[block.name] = static_cast<int>(i);
-            }
-        }
+// 登记新注册的方块,模型由 BakePendingBlockstates 在网格生成前并行烘焙,解码子区块时不处理模型
+static void ProcessNewBlocks(const std::vector<Block>& newBlocks) {
+    if (!newBlocks.empty()) {
+        QueueBlockstatesForBlocks(newBlocks);
     }
+}
 
-    for (int relativeId : blockData) {
-        if (relativeId < 0 || relativeId >= static_cast<int>(blockPalette.size())) {
-            globalBlockData.push_back(0);
-            continue;
+// 把子区块调色板解析为全局ID重映射表,每个调色板条目只查询一次注册表
+// 表长补齐到 2 的幂(不小于 16),超出调色板的下标映射为空气,重映射循环无需分支
+static void BuildPaletteRemap(const std::vector<std::string>& blockPalette, std::vector<int>& remap) {
+    BlockRegistry& registry = BlockRegistry::Global();
+    remap.assign(std::bit_ceil(std::max<size_t>(blockPalette.size(), 16)), 0);
+    std::vector<Block> newBlocks;
+    for (size_t i = 0; i < blockPalette.size(); ++i) {
+        bool isNew = false;
+        remap[i] = registry.Intern(blockPalette[i], &isNew);
+        if (isNew) {
+            newBlocks.push_back(*registry.Get(remap[i]));
         }
+    }
+    ProcessNewBlocks(newBlocks);
+}
 
-        const std::string& blockName = blockPalette[relativeId];
-        auto it = globalBlockMap.find(blockName);
-        if (it != globalBlockMap.end()) {
-            globalBlockData.push_back(it->second);
-        }
-        else {
-            int idx = static_cast<int>(globalBlockPalette.size());
-            globalBlockPalette.emplace_back(blockName); // 新方块添加到全局调色板
-            globalBlockMap[blockName] = idx;
-            globalBlockData.push_back(idx);
-
-            // 为新添加的方块生成模型缓存
-            std::vector<Block> newBlockVector;
-            newBlockVector.push_back(globalBlockPalette.back()); // 获取刚添加的方块
-            try {
-                ProcessBlockstateForBlocks(newBlockVector); // 调用处理函数
-            } catch (const std::exception& e) {
-                std::cerr << "Error in ProcessBlockstateForBlocks: " << e.what() << std::endl;
+// 读取 SkyLight/BlockLight:保留 NBT 中的 4 位布局,所有值相同时只存一个值
+static void ReadNibbleLight(NbtRef lightTag, NibbleLight& light) {
+    if (!lightTag || lightTag.Type() != TagType::BYTE_ARRAY) {
+        light.data.clear();
+        light.value = -1;
+        return;
+    }
+    std::span<const char> rawData = lightTag.Bytes();
+    size_t size = std::min(rawData.size(), size_t(2048));
+    // 统一亮度的字节为 0xNN(两个半字节相同),数据不足 2048 字节时补 0
+    uint8_t first = size > 0 ? static_cast<uint8_t>(rawData[0]) : 0;
+    bool uniform = ((first >> 4) == (first & 0xF)) && (size == 2048 || first == 0);
+    for (size_t i = 1; uniform && i < size; ++i) {
+        uniform = static_cast<uint8_t>(rawData[i]) == first;
+    }
+    if (uniform) {
+        light.data.clear();
+        light.value = static_cast<int8_t>(first & 0xF);
+        return;
+    }
+    light.data.assign(2048, 0);
+    std::memcpy(light.data.data(), rawData.data(), size);
+    light.value = 0;
+}
+
+// 新增函数:解码单个子区块到 entry,不访问 sectionCache,可在加载线程中并行调用
+static bool ProcessSection(int chunkX, int chunkZ, int sectionY, NbtRef sectionTag, SectionCacheEntry& entry) {
+    try {
+    // 获取方块数据(调色板下标),字符串调色板只用于注册,不保存在缓存中
+    NbtRef blo = sectionTag.Child("block_states");
+    std::vector<std::string> blockPalette = getBlockPalette(blo);
+    std::vector<int> blockData = getBlockStatesData(blo, blockPalette.size());
+
+    // 转换为全局ID并注册调色板:子区块调色板保存全局ID,下标数组按调色板大小选择 8 位或 16 位
+    // 同时按调色板条目的不透明属性生成行掩码(YZX 下标的高 8 位为行,低 4 位为 x)
+    thread_local std::vector<int> remap;
+    thread_local std::vector<uint16_t> remapOpaque;
+    BuildPaletteRemap(blockPalette, remap);
+    remapOpaque.resize(remap.size());
+    for (size_t i = 0; i < remap.size(); ++i) {
+        remapOpaque[i] = (GetBlockFlags(remap[i]) & BLOCK_FLAG_OPAQUE) ? 1 : 0;
+    }
+    const int remapMask = static_cast<int>(remap.size()) - 1;
+    const int firstLocal = blockData[0] & remapMask;
+    bool uniformBlocks = true;
+    for (size_t i = 1; i < blockData.size() && uniformBlocks; ++i) {
+        uniformBlocks = (blockData[i] & remapMask) == firstLocal;
+    }
+
+    SectionCacheEntry result;
+    if (uniformBlocks) {
+        result.uniformBlock = remap[firstLocal];
+        result.uniformOpaqueRow = remapOpaque[firstLocal] ? 0xFFFF : 0;
+    } else {
+        const uint16_t* opaqueTable = remapOpaque.data();
+        result.blockPalette = remap;
+        result.opaqueRows.assign(256, 0);
+        if (remap.size() <= 256) {
+            result.blockIndices.resize(blockData.size());
+            for (size_t i = 0; i < blockData.size(); ++i) {
+                int local = blockData[i] & remapMask;
+                result.blockIndices[i] = static_cast<uint8_t>(local);
+                result.opaqueRows[i >> 4] |= static_cast<uint16_t>(opaqueTable[local] << (i & 15));
+            }
+        } else {
+            result.wideBlockIndices.resize(blockData.size());
+            for (size_t i = 0; i < blockData.size(); ++i) {
+                int local = blockData[i] & remapMask;
+                result.wideBlockIndices[i] = static_cast<uint16_t>(local);
+                result.opaqueRows[i >> 4] |= static_cast<uint16_t>(opaqueTable[local] << (i & 15));
             }
         }
     }
 
     // 获取生物群系数据
-    auto bio = getBiomes(sectionTag);
-    std::vector<int> biomeData;
+    NbtRef bio = sectionTag.Child("biomes");
     if (bio) {
         // 旧版格式(1.18~1.19)：biomes 是 INT_ARRAY，64 个 biome registry ID
-        if (bio->type == TagType::INT_ARRAY) {
-            const int* ids = reinterpret_cast<const int*>(bio->payload.data());
-            size_t count = bio->payload.size() / sizeof(int);
-            biomeData.resize(64, 0);
+        if (bio.Type() == TagType::INT_ARRAY) {
+            std::span<const char> ids = bio.Bytes();
+            size_t count = ids.size() / sizeof(int);
+            // 不足 64 项的部分为群系 0
+            result.biomePalette.push_back(0);
             for (size_t i = 0; i < count && i < 64; ++i) {
-                int rawId = ids[i];
+                int rawId;
+                std::memcpy(&rawId, ids.data() + i * sizeof(int), sizeof(int));
                 // 用 ID 生成占位名，确保 biome 被注册
                 std::string name = "minecraft:legacy_biome_";
                 name += std::to_string(rawId);
-                biomeData[i] = Biome::GetId(name);
+                int biomeId = Biome::GetId(name);
+                auto it = std::find(result.biomePalette.begin(), result.biomePalette.end(), biomeId);
+                if (it == result.biomePalette.end()) {
+                    it = result.biomePalette.insert(it, biomeId);
+                }
+                result.biomeIndices[i] = static_cast<uint8_t>(it - result.biomePalette.begin());
             }
         }
         // 新版格式(1.21+)：biomes 是 COMPOUND，含 palette + data
         else {
             try {
                 std::vector<std::string> biomePalette = getBiomePalette(bio);
-                auto dataTag = getChildByName(bio, "data");
+                NbtRef dataTag = bio.Child("data");
 
-                if (dataTag && dataTag->type == TagType::LONG_ARRAY) {
+                if (dataTag && dataTag.Type() == TagType::LONG_ARRAY) {
                     int paletteSize = biomePalette.size();
                     int bitsPerEntry = (paletteSize > 1) ? static_cast<int>(std::ceil(std::log2(paletteSize))) : 1;
-                    int entriesPerLong = 64 / bitsPerEntry;
-                    int mask = (1 << bitsPerEntry) - 1;
-
-                    biomeData.resize(64, 0);
-                    int totalProcessed = 0;
 
-                    const int64_t* data = reinterpret_cast<const int64_t*>(dataTag->payload.data());
-                    size_t dataSize = dataTag->payload.size() / sizeof(int64_t);
-
-                    for (size_t i = 0; i < dataSize && totalProcessed < 64; ++i) {
-                        int64_t value = reverseEndian(data[i]);
-                        for (int pos = 0; pos < entriesPerLong && totalProcessed < 64; ++pos) {
-                            int index = (value >> (pos * bitsPerEntry)) & mask;
-                            if (index < paletteSize) {
-                                biomeData[totalProcessed] = Biome::GetId(biomePalette[index]);
-                            }
-                            totalProcessed++;
+                    // 直接保存调色板下标,每个调色板条目只查询一次群系ID;下标 paletteSize 对应群系 0
+                    int indices[64];
+                    size_t totalProcessed = UnpackPackedLongs(dataTag.Bytes(), bitsPerEntry, indices, 64);
+                    result.biomePalette.resize(biomePalette.size() + 1, 0);
+                    for (size_t i = 0; i < biomePalette.size(); ++i) {
+                        result.biomePalette[i] = Biome::GetId(biomePalette[i]);
+                    }
+                    result.biomeIndices.fill(static_cast<uint8_t>(paletteSize));
+                    for (size_t i = 0; i < totalProcessed; ++i) {
+                        if (indices[i] < paletteSize) {
+                            result.biomeIndices[i] = static_cast<uint8_t>(indices[i]);
                         }
                     }
                 }
                 else if (!biomePalette.empty()) {
-                    int defaultBid = Biome::GetId(biomePalette[0]);
-                    biomeData.assign(64, defaultBid);
+                    result.biomePalette.assign(1, Biome::GetId(biomePalette[0]));
+                    result.biomeIndices.fill(0);
                 }
             }
             catch (const std::exception& e) {
                 std::cerr << "Biome palette parsing failed, using defaults: " << e.what() << std::endl;
+                result.biomePalette.clear();
             }
         }
     }
 
     // 获取光照数据
-    auto processLightData = [&](const std::string& lightType, std::vector<int>& lightData) {
-        auto lightTag = getChildByName(sectionTag, lightType);
-        if (lightTag && lightTag->type == TagType::BYTE_ARRAY) {
-            // 批量解析,每个原始字节产生2个光照值
-            const auto& rawData = lightTag->payload;
-            size_t rawSize = rawData.size();
-            lightData.resize(4096);
-            size_t pairs = std::fmin(rawSize, size_t(2048));
-            for (size_t i = 0; i < pairs; ++i) {
-                uint8_t byteVal = static_cast<uint8_t>(rawData[i]);
-                lightData[2*i]   = byteVal & 0xF;
-                lightData[2*i+1] = (byteVal >> 4) & 0xF;
-            }
-            if (pairs * 2 < 4096) {
-                std::memset(lightData.data() + pairs * 2, 0, (4096 - pairs * 2) * sizeof(int));
-            }
-        }
-        else {
-            lightData = { -1 };
-        }
-    };
-
-    std::vector<int> skyLightData;
-    processLightData("SkyLight", skyLightData);
-    std::vector<int> blockLightData;
-    processLightData("BlockLight", blockLightData);
-
-    // 存储到统一的缓存
-    int adjustedSectionY = AdjustSectionY(sectionY);
-    auto blockKey = std::make_tuple(chunkX, chunkZ, adjustedSectionY);
-    sectionCache[blockKey] = {
-        std::move(skyLightData),      // skyLight
-        std::move(blockLightData),    // blockLight
-        std::move(globalBlockData),   // blockData
-        std::move(biomeData),         // biomeData
-        std::move(blockPalette)       // blockPalette
-    };
+    ReadNibbleLight(sectionTag.Child("SkyLight"), result.skyLight);
+    ReadNibbleLight(sectionTag.Child("BlockLight"), result.blockLight);
+
+    // 由调用方存入统一的缓存
+    entry = std::move(result);
+    return true;
 }
 catch (const std::exception& e) {
     std::cerr << "Error in ProcessSection (" << chunkX << ", " << chunkZ << ", " << sectionY << "): " << e.what() << std::endl;
+    return false;
 }
 }
 
-// 新函数：清理指定 (chunkX, chunkZ) 的所有 sectionCache 条目
+// 新函数：清理指定 (chunkX, chunkZ) 的所有 sectionCache 条目(整列删除,包括延迟解码的子区块)
 void ClearSectionCacheForChunk(int chunkX, int chunkZ) {
     std::unique_lock<std::shared_mutex> write_lock(sectionCacheMutex);
-    int removed_count = 0;
-    for (auto it = sectionCache.begin(); it != sectionCache.end(); ) {
-        if (std::get<0>(it->first) == chunkX && std::get<1>(it->first) == chunkZ) {
-            // 调试输出：打印将要删除的条目的键
-            // std::cout << "Debug: Attempting to remove sectionCache entry for (" 
-            //           << std::get<0>(it->first) << ", " 
-            //           << std::get<1>(it->first) << ", " 
-            //           << std::get<2>(it->first) << ")" << std::endl;
-            it = sectionCache.erase(it); // erase 返回下一个有效的迭代器
-            removed_count++;
-        }
-        else {
-            ++it;
-        }
-    }
-    if (removed_count > 0) {
-        //std::cout << "Debug: Cleared " << removed_count << " sectionCache entries for chunk (" << chunkX << ", " << chunkZ << ")" << std::endl;
-    }
+    sectionCache.EraseColumn(chunkX, chunkZ);
+}
+
+void SetSectionCacheGrid(int chunkXStart, int chunkXEnd, int chunkZStart, int chunkZEnd) {
+    std::unique_lock<std::shared_mutex> write_lock(sectionCacheMutex);
+    sectionCache.SetGrid(chunkXStart, chunkXEnd, chunkZStart, chunkZEnd);
+}
+
+void ReclaimSectionCache() {
+    std::unique_lock<std::shared_mutex> write_lock(sectionCacheMutex);
+    sectionCache.Reclaim();
 }
 
 // --- 新增辅助函数 ---
+// 复制标签的原始载荷,供仍基于 std::vector<char> 的辅助函数(如 readIntArray)使用
+static std::vector<char> ToPayload(NbtRef tag) {
+    std::span<const char> bytes = tag.Bytes();
+    return std::vector<char>(bytes.begin(), bytes.end());
+}
+
 // 解析 littletiles 的 tiles 复合标签,返回一个包含所有 tile 条目的向量
-static std::vector<LittleTilesTileEntry> ParseLittleTilesTiles(const NbtTagPtr& tilesTag) {
+static std::vector<LittleTilesTileEntry> ParseLittleTilesTiles(NbtRef tilesTag) {
     std::vector<LittleTilesTileEntry> tileEntries;
-    if (!tilesTag || tilesTag->type != TagType::COMPOUND) {
+    if (!tilesTag || tilesTag.Type() != TagType::COMPOUND) {
         return tileEntries;
     }
 
     // 遍历 tiles 复合标签中的每个键,例如 "minecraft:granite"、"minecraft:stone"
-    for (const auto& tileGroupTag : tilesTag->children) {
+    for (NbtRef tileGroupTag : tilesTag) {
         // 确保子标签类型为 ListTag
-        if (tileGroupTag->type != TagType::LIST)
+        if (tileGroupTag.Type() != TagType::LIST)
             continue;
 
         // 使用子标签的 name 作为默认的 blockName
-        std::string blockName = tileGroupTag->name;
+        std::string blockName(tileGroupTag.Name());
         // 新建一个 tile 条目
         LittleTilesTileEntry tileEntry;
         tileEntry.blockName = blockName;
@@ -307,12 +323,12 @@ static std::vector<LittleTilesTileEntry> ParseLittleTilesTiles(const NbtTagPtr&
         // 标记:第一个 IntArrayTag 作为颜色,其余均作为 box
         bool isFirstArray = true;
         // 遍历 ListTag 下的每个子节点,均为 IntArrayTag
-        for (const auto& intArrayTag : tileGroupTag->children) {
-            if (intArrayTag->type != TagType::INT_ARRAY)
+        for (NbtRef intArrayTag : tileGroupTag) {
+            if (intArrayTag.Type() != TagType::INT_ARRAY)
                 continue;
 
             // 解析 payload 为 int 数组
-            std::vector<int> values = readIntArray(intArrayTag->payload);
+            std::vector<int> values = readIntArray(ToPayload(intArrayTag));
             if (isFirstArray) {
                 // 第一个数组作为颜色数据
                 tileEntry.color = values;
@@ -327,8 +343,8 @@ static std::vector<LittleTilesTileEntry> ParseLittleTilesTiles(const NbtTagPtr&
                         return std::vector<int>{ (b >> 4) & 0x0F, b & 0x0F };
                         };
 
-                    // 在 box 处理逻辑里,拿到 intArrayTag->payload
-                    const auto& pl = intArrayTag->payload;
+                    // 在 box 处理逻辑里,拿到 intArrayTag 的原始字节
+                    std::span<const char> pl = intArrayTag.Bytes();
 
                     unsigned char b0 = pl[3];
                     unsigned char b1 = pl[2];
@@ -366,29 +382,29 @@ static std::vector<LittleTilesTileEntry> ParseLittleTilesTiles(const NbtTagPtr&
     return tileEntries;
 }
 
-void ProcessEntityBlocks(int chunkX, int chunkZ, const NbtTagPtr& blockEntitiesTag) {
+void ProcessEntityBlocks(int chunkX, int chunkZ, NbtRef blockEntitiesTag) {
     std::vector<std::shared_ptr<EntityBlock>> entityBlocks;
 
-    for (const auto& entityTag : blockEntitiesTag->children) {
+    for (NbtRef entityTag : blockEntitiesTag) {
         // 提取基础信息
-        auto idTag = getChildByName(entityTag, "id");
-        auto xTag = getChildByName(entityTag, "x");
-        auto yTag = getChildByName(entityTag, "y");
-        auto zTag = getChildByName(entityTag, "z");
+        NbtRef idTag = entityTag.Child("id");
+        NbtRef xTag = entityTag.Child("x");
+        NbtRef yTag = entityTag.Child("y");
+        NbtRef zTag = entityTag.Child("z");
 
         std::string id;
         int x = 0, y = 0, z = 0;
-        if (idTag && idTag->type == TagType::STRING) {
-            id = std::string(idTag->payload.begin(), idTag->payload.end());
+        if (idTag && idTag.Type() == TagType::STRING) {
+            id = std::string(idTag.AsString());
         }
-        if (xTag && xTag->type == TagType::INT) {
-            x = bytesToInt(xTag->payload);
+        if (xTag && xTag.Type() == TagType::INT) {
+            x = xTag.AsInt();
         }
-        if (yTag && yTag->type == TagType::INT) {
-            y = bytesToInt(yTag->payload);
+        if (yTag && yTag.Type() == TagType::INT) {
+            y = yTag.AsInt();
         }
-        if (zTag && zTag->type == TagType::INT) {
-            z = bytesToInt(zTag->payload);
+        if (zTag && zTag.Type() == TagType::INT) {
+            z = zTag.AsInt();
         }
 
         // 创建实体
@@ -402,79 +418,75 @@ void ProcessEntityBlocks(int chunkX, int chunkZ, const NbtTagPtr& blockEntitiesT
             yuushyaEntity->y = y;
             yuushyaEntity->z = z;
 
-            auto blocksTag = getChildByName(entityTag, "Blocks");
-            if (blocksTag && blocksTag->type == TagType::LIST) {
-                for (const auto& blockTag : blocksTag->children) {
-                    if (blockTag && blockTag->type == TagType::COMPOUND) {
+            NbtRef blocksTag = entityTag.Child("Blocks");
+            if (blocksTag && blocksTag.Type() == TagType::LIST) {
+                for (NbtRef blockTag : blocksTag) {
+                    if (blockTag && blockTag.Type() == TagType::COMPOUND) {
                         YuushyaBlockEntry entry;
 
                         // 解析 BlockState
-                        auto blockStateTag = getChildByName(blockTag, "BlockState");
-                        if (blockStateTag && blockStateTag->type == TagType::COMPOUND) {
+                        NbtRef blockStateTag = blockTag.Child("BlockState");
+                        if (blockStateTag && blockStateTag.Type() == TagType::COMPOUND) {
                             std::string blockName;
-                            auto nameTag = getChildByName(blockStateTag, "Name");
-                            if (nameTag && nameTag->type == TagType::STRING) {
-                                blockName = std::string(nameTag->payload.begin(), nameTag->payload.end());
+                            NbtRef nameTag = blockStateTag.Child("Name");
+                            if (nameTag && nameTag.Type() == TagType::STRING) {
+                                blockName = std::string(nameTag.AsString());
                             }
 
                             // 解析 Properties
-                            auto propertiesTag = getChildByName(blockStateTag, "Properties");
-                            if (propertiesTag && propertiesTag->type == TagType::COMPOUND) {
+                            NbtRef propertiesTag = blockStateTag.Child("Properties");
+                            if (propertiesTag && propertiesTag.Type() == TagType::COMPOUND) {
                                 std::string propertiesStr;
-                                for (const auto& prop : propertiesTag->children) {
+                                for (NbtRef prop : propertiesTag) {
                                     if (!propertiesStr.empty()) propertiesStr += ",";
-                                    propertiesStr += prop->name + ":" + std::string(prop->payload.begin(), prop->payload.end());
+                                    propertiesStr += std::string(prop.Name()) + ":" + std::string(prop.Bytes().begin(), prop.Bytes().end());
                                 }
                                 if (!propertiesStr.empty()) {
                                     blockName += "[" + propertiesStr + "]";
                                 }
                             }
 
-                            // 转换为全局 ID
-                            static std::unordered_map<std::string, int> globalBlockMap;
+                            // 转换为全局 ID(与子区块共用注册表)
                             if (!blockName.empty()) {
-                                auto it = globalBlockMap.find(blockName);
-                                if (it != globalBlockMap.end()) {
-                                    entry.blockid = it->second;
-                                }
-                                else {
-                                    entry.blockid = static_cast<int>(globalBlockPalette.size());
-                                    globalBlockPalette.emplace_back(blockName);
-                                    globalBlockMap[blockName] = entry.blockid;
+                                BlockRegistry& registry = BlockRegistry::Global();
+                                bool isNew = false;
+                                entry.blockid = registry.Intern(blockName, &isNew);
+                                if (isNew) {
+                                    ProcessNewBlocks({ *registry.Get(entry.blockid) });
                                 }
                             }
                         }
 
                         // 解析其他属性
-                        auto showPosTag = getChildByName(blockTag, "ShowPos");
-                        if (showPosTag && showPosTag->type == TagType::LIST) {
-                            for (const auto& pos : showPosTag->children) {
-                                entry.showPos.push_back(bytesToDouble(pos->payload));
+                        NbtRef showPosTag = blockTag.Child("ShowPos");
+                        if (showPosTag && showPosTag.Type() == TagType::LIST) {
+                            for (NbtRef pos : showPosTag) {
+                                entry.showPos.push_back(pos.AsDouble());
                             }
                         }
 
-                        auto showRotationTag = getChildByName(blockTag, "ShowRotation");
-                        if (showRotationTag && showRotationTag->type == TagType::LIST) {
-                            for (const auto& rot : showRotationTag->children) {
-                                entry.showRotation.push_back(bytesToFloat(rot->payload));
+                        NbtRef showRotationTag = blockTag.Child("ShowRotation");
+                        if (showRotationTag && showRotationTag.Type() == TagType::LIST) {
+                            for (NbtRef rot : showRotationTag) {
+                                entry.showRotation.push_back(rot.AsFloat());
                             }
                         }
 
-                        auto showScalesTag = getChildByName(blockTag, "ShowScales");
-                        if (showScalesTag && showScalesTag->type == TagType::LIST) {
-                            for (const auto& scale : showScalesTag->children) {
-                                entry.showScales.push_back(bytesToFloat(scale->payload));
+                        NbtRef showScalesTag = blockTag.Child("ShowScales");
+                        if (showScalesTag && showScalesTag.Type() == TagType::LIST) {
+                            for (NbtRef scale : showScalesTag) {
+                                entry.showScales.push_back(scale.AsFloat());
                             }
                         }
 
-                        auto isShownTag = getChildByName(blockTag, "isShown");
-                        if (isShownTag && isShownTag->type == TagType::BYTE) {
-                            entry.isShown = bytesToByte(isShownTag->payload);
+                        NbtRef isShownTag = blockTag.Child("isShown");
+                        if (isShownTag && isShownTag.Type() == TagType::BYTE) {
+                            entry.isShown = isShownTag.AsByte();
                         }
 
-                        auto slotTag = getChildByName(blockTag, "Slot");
-                        if (slotTag && slotTag->type == TagType::BYTE) {
-                            entry.slot = bytesToByte(slotTag->payload);
+                        NbtRef slotTag = blockTag.Child("Slot");
+                        if (slotTag && slotTag.Type() == TagType::BYTE) {
+                            entry.slot = slotTag.AsByte();
                         }
 
                         yuushyaEntity->blocks.push_back(entry);
@@ -483,11 +495,11 @@ void ProcessEntityBlocks(int chunkX, int chunkZ, const NbtTagPtr& blockEntitiesT
             }
 
             // 解析 ControlSlot 和 keepPacked
-            auto controlSlotTag = getChildByName(entityTag, "ControlSlot");
-            if (controlSlotTag) yuushyaEntity->controlSlot = bytesToByte(controlSlotTag->payload);
+            NbtRef controlSlotTag = entityTag.Child("ControlSlot");
+            if (controlSlotTag) yuushyaEntity->controlSlot = controlSlotTag.AsByte();
 
-            auto keepPackedTag = getChildByName(entityTag, "keepPacked");
-            if (keepPackedTag) yuushyaEntity->keepPacked = bytesToByte(keepPackedTag->payload);
+            NbtRef keepPackedTag = entityTag.Child("keepPacked");
+            if (keepPackedTag) yuushyaEntity->keepPacked = keepPackedTag.AsByte();
 
             entityBlocks.push_back(yuushyaEntity);
         }
@@ -498,33 +510,33 @@ void ProcessEntityBlocks(int chunkX, int chunkZ, const NbtTagPtr& blockEntitiesT
             littleTilesEntity->y = y;
             littleTilesEntity->z = z;
             // 解析 grid 值(如果存在)
-            auto gridTag = getChildByName(entityTag, "grid");
+            NbtRef gridTag = entityTag.Child("grid");
 
-            if (gridTag && gridTag->type == TagType::INT) {
-                littleTilesEntity->grid = bytesToInt(gridTag->payload);
+            if (gridTag && gridTag.Type() == TagType::INT) {
+                littleTilesEntity->grid = gridTag.AsInt();
             }
             // 解析 content 标签
-            auto contentTag = getChildByName(entityTag, "content");
-            if (contentTag && contentTag->type == TagType::COMPOUND) {
+            NbtRef contentTag = entityTag.Child("content");
+            if (contentTag && contentTag.Type() == TagType::COMPOUND) {
                 // 解析顶层的 tiles
-                auto tilesTag = getChildByName(contentTag, "tiles");
+                NbtRef tilesTag = contentTag.Child("tiles");
                 littleTilesEntity->tiles = ParseLittleTilesTiles(tilesTag);
 
                 // 解析 children 列表
-                auto childrenTag = getChildByName(contentTag, "children");
-                if (childrenTag && childrenTag->type == TagType::LIST) {
-                    for (const auto& childCompoundTag : childrenTag->children) {
-                        if (childCompoundTag && childCompoundTag->type == TagType::COMPOUND) {
+                NbtRef childrenTag = contentTag.Child("children");
+                if (childrenTag && childrenTag.Type() == TagType::LIST) {
+                    for (NbtRef childCompoundTag : childrenTag) {
+                        if (childCompoundTag && childCompoundTag.Type() == TagType::COMPOUND) {
                             LittleTilesChildEntry childEntry;
 
                             // 解析 coord
-                            auto coordTag = getChildByName(childCompoundTag, "coord");
-                            if (coordTag && coordTag->type == TagType::INT_ARRAY) {
-                                childEntry.coord = readIntArray(coordTag->payload);
+                            NbtRef coordTag = childCompoundTag.Child("coord");
+                            if (coordTag && coordTag.Type() == TagType::INT_ARRAY) {
+                                childEntry.coord = readIntArray(ToPayload(coordTag));
                             }
 
                             // 解析 tiles
-                            auto childTilesTag = getChildByName(childCompoundTag, "tiles");
+                            NbtRef childTilesTag = childCompoundTag.Child("tiles");
                             childEntry.tiles = ParseLittleTilesTiles(childTilesTag);
 
                             littleTilesEntity->children.push_back(childEntry);
@@ -554,83 +566,178 @@ void ProcessEntityBlocks(int chunkX, int chunkZ, const NbtTagPtr& blockEntitiesT
 }
 
 
+// 区块 NBT 白名单:只保留导出需要的字段,实体、结构、计划刻、PostProcessing 等子树在解析时直接跳过
+static const NbtSchema& ChunkSchema() {
+    static const NbtSchema schema = [] {
+        NbtSchema s;
+        s.Keep("yPos")
+         .Keep("Heightmaps")
+         .Keep("block_entities")
+         .Keep("sections/Y")
+         .Keep("sections/block_states")
+         .Keep("sections/biomes")
+         .Keep("sections/SkyLight")
+         .Keep("sections/BlockLight");
+        return s;
+    }();
+    return schema;
+}
+
 // 修改 LoadAndCacheBlockData,使其处理整个 chunk 的所有子区块
+// 读取、解析和解码都不持有 sectionCacheMutex,只在最后写入缓存时加锁,加载线程之间不再串行
 void LoadAndCacheBlockData(int chunkX, int chunkZ) {
-    auto key = std::make_tuple(chunkX, chunkZ, 0);
-    {
-        std::shared_lock<std::shared_mutex> read_lock(sectionCacheMutex);
-        if (sectionCache.find(key) != sectionCache.end()) return;
-    }
-    std::unique_lock<std::shared_mutex> write_lock(sectionCacheMutex);
-    if (sectionCache.find(key) != sectionCache.end()) return;
-    // 计算区域坐标
-    int regionX, regionZ;
-    chunkToRegion(chunkX, chunkZ, regionX, regionZ);
-
-    // 获取区域数据
-    const auto& regionData = GetRegionFromCache(regionX, regionZ);
-
+    // 已加载检查无需加锁(区块列以原子指针发布)
+    if (sectionCache.IsLoaded(chunkX, chunkZ)) return;
     // 获取区块数据
-    std::vector<char> chunkData = GetChunkNBTData(regionData, chunkX, chunkZ);
-    // 如果数据为空，表示区块文件不存在或读取失败，直接跳过并缓存空条目
-    if (chunkData.empty()) {
+    // 每个线程复用解压缓冲区
+    thread_local std::vector<char> chunkData;
+    // 读取失败表示区块文件不存在或读取失败，直接跳过并缓存空条目
+    if (!GetChunkNBTData(chunkX, chunkZ, chunkData) || chunkData.empty()) {
         std::cerr << "警告: 无法加载区块 (" << chunkX << "," << chunkZ << ")，已跳过。" << std::endl;
-        sectionCache[key] = SectionCacheEntry();
+        std::unique_lock<std::shared_mutex> write_lock(sectionCacheMutex);
+        sectionCache.GetOrCreateColumn(chunkX, chunkZ).loaded.store(true, std::memory_order_release);
         return;
     }
-    size_t index = 0;
-    auto tag = readTag(chunkData, index);
-
-    auto yPosTag = getChildByName(tag, "yPos");
-    if (yPosTag && yPosTag->type == TagType::INT) {
-        minSectionY = bytesToInt(yPosTag->payload);
+    // 每个线程复用 NBT 视图的节点数组
+    thread_local NbtDocument document;
+    try {
+        document.Parse(chunkData, &ChunkSchema());
+    } catch (const std::exception& e) {
+        std::cerr << "警告: 区块 (" << chunkX << "," << chunkZ << ") NBT 解析失败: " << e.what() << std::endl;
+        std::unique_lock<std::shared_mutex> write_lock(sectionCacheMutex);
+        sectionCache.GetOrCreateColumn(chunkX, chunkZ).loaded.store(true, std::memory_order_release);
+        return;
     }
+    NbtRef tag = document.Root();
+
+    NbtRef yPosTag = tag.Child("yPos");
+    bool hasYPos = yPosTag && yPosTag.Type() == TagType::INT;
+    int yPos = hasYPos ? yPosTag.AsInt() : 0;
     // 处理高度图
-    auto heightMapsTag = getChildByName(tag, "Heightmaps");
-    if (heightMapsTag && heightMapsTag->type == TagType::COMPOUND) {
+    NbtRef heightMapsTag = tag.Child("Heightmaps");
+    if (heightMapsTag && heightMapsTag.Type() == TagType::COMPOUND) {
         std::unique_lock<std::shared_mutex> hm_lock(heightMapCacheMutex); // 加锁
         for (const auto& mapType : mapTypes) {
-            auto mapDataTag = getChildByName(heightMapsTag, mapType);
-            if (mapDataTag && mapDataTag->type == TagType::LONG_ARRAY) {
-                size_t numLongs = mapDataTag->payload.size() / sizeof(int64_t);
-                const int64_t* rawData = reinterpret_cast<const int64_t*>(mapDataTag->payload.data());
-                std::vector<int64_t> longData(rawData, rawData + numLongs);
-
-                std::vector<int> heights = DecodeHeightMap(longData);
+            NbtRef mapDataTag = heightMapsTag.Child(mapType);
+            if (mapDataTag && mapDataTag.Type() == TagType::LONG_ARRAY) {
+                std::vector<int> heights = DecodeHeightMap(mapDataTag.Bytes());
                 heightMapCache[std::make_pair(chunkX, chunkZ)][mapType] = heights;
             }
         }
         // hm_lock 在此处自动解锁
     }
     //提取实体方块
-    auto blockEntitiesTag = getChildByName(tag, "block_entities");
-    if (blockEntitiesTag && blockEntitiesTag->type == TagType::LIST) {
+    NbtRef blockEntitiesTag = tag.Child("block_entities");
+    if (blockEntitiesTag && blockEntitiesTag.Type() == TagType::LIST) {
         ProcessEntityBlocks(chunkX, chunkZ, blockEntitiesTag); 
     }
 
     // 提取所有子区块
-    auto sectionsTag = getChildByName(tag, "sections");
-    if (!sectionsTag || sectionsTag->type != TagType::LIST) {
-        return; // 没有子区块
-    }
+    std::vector<std::pair<int, SectionCacheEntry>> decodedSections;
+    std::vector<std::pair<int, std::vector<char>>> rawSections;
+    NbtRef sectionsTag = tag.Child("sections");
+    if (sectionsTag && sectionsTag.Type() == TagType::LIST) {
+        // 只解码导出范围内的子区块,上下各多一层用于面剔除
+        const int decodeYStart = config.sectionYStart - 1;
+        const int decodeYEnd = config.sectionYEnd + 1;
+        decodedSections.reserve(sectionsTag.Size());
+
+        // 遍历所有子区块
+        for (NbtRef sectionTag : sectionsTag) {
+            int sectionY = -1;
+            NbtRef yTag = sectionTag.Child("Y");
+
+            if (yTag && yTag.Type() == TagType::BYTE) {
+                sectionY = static_cast<int>(yTag.AsByte());
+            }
 
-    // 遍历所有子区块
-    for (const auto& sectionTag : sectionsTag->children) {
-        int sectionY = -1;
-        auto yTag = getChildByName(sectionTag, "Y");
-        
-        if (yTag && yTag->type == TagType::BYTE) {
-            sectionY = static_cast<int>(yTag->payload[0]);
+            if (sectionY < decodeYStart || sectionY > decodeYEnd) {
+                // 范围外的子区块只复制原始字节,解压缓冲区会被下一个区块复用
+                std::span<const char> raw = sectionTag.RawCompound();
+                std::vector<char>& bytes = rawSections.emplace_back(AdjustSectionY(sectionY), std::vector<char>()).second;
+                bytes.reserve(raw.size() + 3);
+                bytes.assign({ static_cast<char>(TagType::COMPOUND), 0, 0 });
+                bytes.insert(bytes.end(), raw.begin(), raw.end());
+                continue;
+            }
+
+            // 处理子区块
+            SectionCacheEntry entry;
+            if (ProcessSection(chunkX, chunkZ, sectionY, sectionTag, entry)) {
+                decodedSections.emplace_back(AdjustSectionY(sectionY), std::move(entry));
+            }
         }
+    }
+
+    std::unique_lock<std::shared_mutex> write_lock(sectionCacheMutex);
+    SectionStore::Column& column = sectionCache.GetOrCreateColumn(chunkX, chunkZ);
+    if (column.loaded.load(std::memory_order_relaxed)) return; // 其他线程已加载同一区块
+    if (hasYPos) {
+        minSectionY = yPos;
+    }
+    for (auto& [adjustedSectionY, entry] : decodedSections) {
+        sectionCache.Insert(chunkX, chunkZ, adjustedSectionY, std::move(entry));
+    }
+    for (auto& [adjustedSectionY, bytes] : rawSections) {
+        column.deferredSections[adjustedSectionY] = std::move(bytes);
+    }
+    column.deferredCount.store(static_cast<int>(column.deferredSections.size()), std::memory_order_release);
+    column.loaded.store(true, std::memory_order_release);
+}
+
+void LoadDeferredSection(int chunkX, int chunkZ, int cacheSectionY) {
+    {
+        // 大多数调用没有待解码数据,先无锁检查(区块列按 RCU 发布,读取无需加锁)
+        const SectionStore::Column* column = sectionCache.FindColumnMutable(chunkX, chunkZ);
+        if (!column || column->deferredCount.load(std::memory_order_acquire) == 0) return;
+    }
+    std::vector<char> bytes;
+    {
+        std::unique_lock<std::shared_mutex> write_lock(sectionCacheMutex);
+        SectionStore::Column* column = sectionCache.FindColumnMutable(chunkX, chunkZ);
+        if (!column) return;
+        auto sectionIt = column->deferredSections.find(cacheSectionY);
+        if (sectionIt == column->deferredSections.end()) return;
+
+        bytes = std::move(sectionIt->second);
+        column->deferredSections.erase(sectionIt);
+        column->deferredCount.store(static_cast<int>(column->deferredSections.size()), std::memory_order_release);
+    }
 
-        // 处理子区块
-        ProcessSection(chunkX, chunkZ, sectionY, sectionTag);
+    thread_local NbtDocument document;
+    try {
+        document.Parse(bytes);
+    } catch (const std::exception& e) {
+        std::cerr << "警告: 子区块 (" << chunkX << "," << chunkZ << "," << cacheSectionY << ") NBT 解析失败: " << e.what() << std::endl;
+        return;
+    }
+    NbtRef sectionTag = document.Root();
+    int sectionY = -1;
+    NbtRef yTag = sectionTag.Child("Y");
+    if (yTag && yTag.Type() == TagType::BYTE) {
+        sectionY = static_cast<int>(yTag.AsByte());
+    }
+    SectionCacheEntry entry;
+    if (ProcessSection(chunkX, chunkZ, sectionY, sectionTag, entry)) {
+        std::unique_lock<std::shared_mutex> write_lock(sectionCacheMutex);
+        sectionCache.Insert(chunkX, chunkZ, cacheSectionY, std::move(entry));
     }
 }
 
 // --------------------------------------------------------------------------------
 // 方块ID查询相关函数
 // --------------------------------------------------------------------------------
+// 查找子区块,延迟保存的子区块(导出范围之外,例如 LOD 邻居探测)在首次查询时解码
+// 区块未加载时返回 nullptr
+static const SectionCacheEntry* FindOrDecodeSection(int chunkX, int chunkZ, int cacheSectionY) {
+    const SectionCacheEntry* section = sectionCache.Find(chunkX, chunkZ, cacheSectionY);
+    if (!section) {
+        LoadDeferredSection(chunkX, chunkZ, cacheSectionY);
+        section = sectionCache.Find(chunkX, chunkZ, cacheSectionY);
+    }
+    return section;
+}
+
 // 获取方块ID
 int GetBlockId(int blockX, int blockY, int blockZ) {
     int chunkX, chunkZ;
@@ -638,29 +745,47 @@ int GetBlockId(int blockX, int blockY, int blockZ) {
 
     int sectionY;
     blockYToSectionY(blockY, sectionY);
-    int adjustedSectionY = AdjustSectionY(sectionY);
-    auto blockKey = std::make_tuple(chunkX, chunkZ, adjustedSectionY);
-    auto it = sectionCache.find(blockKey);
-    if (it == sectionCache.end()) {
+    const SectionCacheEntry* section = FindOrDecodeSection(chunkX, chunkZ, AdjustSectionY(sectionY));
+    if (!section) {
         return 0; // 区块未预加载，返回空气
     }
-    const auto& blockData = it->second.blockData;
     int relativeX = mod16(blockX);
     int relativeY = mod16(blockY);
     int relativeZ = mod16(blockZ);
     int yzx = toYZX(relativeX, relativeY, relativeZ);
 
-    return (yzx < blockData.size()) ? blockData[yzx] : 0;
+    return section->BlockAt(yzx);
+}
+
+// 查找方块所在子区块,未加载时返回 nullptr
+static const SectionCacheEntry* FindSection(int blockX, int blockY, int blockZ) {
+    int chunkX, chunkZ;
+    blockToChunk(blockX, blockZ, chunkX, chunkZ);
+    int sectionY;
+    blockYToSectionY(blockY, sectionY);
+    return FindOrDecodeSection(chunkX, chunkZ, AdjustSectionY(sectionY));
+}
+
+// 读取子区块 (y, z) 行的不透明掩码,子区块不存在时为 0
+static inline uint16_t OpaqueRow(const SectionCacheEntry* section, int localY, int localZ) {
+    return section ? section->OpaqueRow(localY, localZ) : 0;
+}
+
+// 方块是否不透明(跨子区块的邻居使用)
+static inline bool IsOpaqueAt(int blockX, int blockY, int blockZ) {
+    return (OpaqueRow(FindSection(blockX, blockY, blockZ), mod16(blockY), mod16(blockZ)) >> mod16(blockX)) & 1;
 }
 
 // 获取方块ID时同时获取相邻方块的air状态,返回当前方块ID
 int GetBlockIdWithNeighbors(int blockX, int blockY, int blockZ, bool* neighborIsAir, int* fluidLevels) {
-    int currentId = GetBlockId(blockX, blockY, blockZ);
-    Block currentBlock = GetBlockById(currentId);
-    std::string currentBaseName = currentBlock.GetNameAndNameSpaceWithoutState();
+    const SectionCacheEntry* section = FindSection(blockX, blockY, blockZ);
+    int localX = mod16(blockX);
+    int localY = mod16(blockY);
+    int localZ = mod16(blockZ);
+    int yzx = toYZX(localX, localY, localZ);
+    int currentId = section ? section->BlockAt(yzx) : 0;
 
-    bool isFluid = fluidDefinitions.find(currentBaseName) != fluidDefinitions.end();
-    bool hasFluidData = (currentBlock.level != -1);
+    bool hasFluidData = (GetBlockFlags(currentId) & BLOCK_FLAG_HAS_FLUID) != 0;
 
     // 统一处理 neighborIsAir 数组(6个方向)
     if (neighborIsAir != nullptr) {
@@ -673,33 +798,45 @@ int GetBlockIdWithNeighbors(int blockX, int blockY, int blockZ, bool* neighborIs
             {0, 0, 1}     // 南(Z+)
         } };
 
-        for (size_t i = 0; i < directions.size(); ++i) {
-            int dx, dy, dz;
-            std::tie(dx, dy, dz) = directions[i];
-            int nx = blockX + dx;
-            int ny = blockY + dy;
-            int nz = blockZ + dz;
-
-            // 如果启用了保留边界面,则直接判断
-            if (config.keepBoundary &&
-                ((nx == config.maxX + 1) || (nx == config.minX - 1) ||
-                    (nz == config.maxZ + 1) || (nz == config.minZ - 1))) {
-                neighborIsAir[i] = true;
-                continue;
+        if (!hasFluidData) {
+            // 非流体方块:邻居是否遮挡只取决于不透明位,同一子区块内直接从行掩码移位读取
+            uint16_t row = OpaqueRow(section, localY, localZ);
+            bool opaque[6] = {
+                localY < 15 ? ((OpaqueRow(section, localY + 1, localZ) >> localX) & 1) != 0 : IsOpaqueAt(blockX, blockY + 1, blockZ),
+                localY > 0 ? ((OpaqueRow(section, localY - 1, localZ) >> localX) & 1) != 0 : IsOpaqueAt(blockX, blockY - 1, blockZ),
+                localX > 0 ? ((row >> (localX - 1)) & 1) != 0 : IsOpaqueAt(blockX - 1, blockY, blockZ),
+                localX < 15 ? ((row >> (localX + 1)) & 1) != 0 : IsOpaqueAt(blockX + 1, blockY, blockZ),
+                localZ > 0 ? ((OpaqueRow(section, localY, localZ - 1) >> localX) & 1) != 0 : IsOpaqueAt(blockX, blockY, blockZ - 1),
+                localZ < 15 ? ((OpaqueRow(section, localY, localZ + 1) >> localX) & 1) != 0 : IsOpaqueAt(blockX, blockY, blockZ + 1)
+            };
+            for (size_t i = 0; i < directions.size(); ++i) {
+                neighborIsAir[i] = !opaque[i];
             }
-
-            int neighborId = GetBlockId(nx, ny, nz);
-            Block neighborBlock = GetBlockById(neighborId);
-
-            if (hasFluidData) {
-                std::string neighborBase = neighborBlock.GetNameAndNameSpaceWithoutState();
-                bool isSameFluid = (currentBaseName == neighborBase);
-                bool neighborIsFluid = (fluidDefinitions.find(neighborBase) != fluidDefinitions.end());
-                neighborIsAir[i] = (isSameFluid && (neighborBlock.level != 0 && neighborBlock.level != -1)) ||
-                    (neighborBlock.level != 0 && !neighborIsFluid && neighborBlock.air);
+        }
+        else {
+            int currentBaseId = GetBlockTraits(currentId).baseId;
+            for (size_t i = 0; i < directions.size(); ++i) {
+                int dx, dy, dz;
+                std::tie(dx, dy, dz) = directions[i];
+                int neighborId = GetBlockId(blockX + dx, blockY + dy, blockZ + dz);
+                uint8_t neighborFlags = GetBlockFlags(neighborId);
+
+                // 邻居为同种流体且不是源/含水(level 非 0 非 -1),或邻居为非流体的非实心方块
+                bool flowingNeighbor = (neighborFlags & (BLOCK_FLAG_HAS_FLUID | BLOCK_FLAG_WATERLOGGED)) == BLOCK_FLAG_HAS_FLUID;
+                bool openNeighbor = (neighborFlags & (BLOCK_FLAG_WATERLOGGED | BLOCK_FLAG_FLUID | BLOCK_FLAG_OPAQUE)) == 0;
+                neighborIsAir[i] = (flowingNeighbor && GetBlockTraits(neighborId).baseId == currentBaseId) || openNeighbor;
             }
-            else {
-                neighborIsAir[i] = neighborBlock.air;
+        }
+
+        // 如果启用了保留边界面,则直接判断
+        if (config.keepBoundary) {
+            for (size_t i = 0; i < directions.size(); ++i) {
+                int nx = blockX + std::get<0>(directions[i]);
+                int nz = blockZ + std::get<2>(directions[i]);
+                if ((nx == config.maxX + 1) || (nx == config.minX - 1) ||
+                    (nz == config.maxZ + 1) || (nz == config.minZ - 1)) {
+                    neighborIsAir[i] = true;
+                }
             }
         }
     }
@@ -765,21 +902,15 @@ int GetHeightMapY(int blockX, int blockZ, const std::string& heightMapType) {
 
 int GetLevel(int blockX, int blockY, int blockZ) {
     int currentId = GetBlockId(blockX, blockY, blockZ);
-    Block currentBlock = GetBlockById(currentId);
-    std::string baseName = currentBlock.GetNameAndNameSpaceWithoutState(); // 获取带命名空间的完整名称
+    const BlockTraits& currentBlock = GetBlockTraits(currentId);
 
     // 判断当前方块是否是注册流体或已有level标记
-    bool isFluid = fluidDefinitions.find(baseName) != fluidDefinitions.end();
-
-    if (isFluid || currentBlock.level == 0) {
+    if (currentBlock.isFluid || currentBlock.level == 0) {
         // 检查上方方块
         int upperId = GetBlockId(blockX, blockY + 1, blockZ);
-        Block upperBlock = GetBlockById(upperId);
-        std::string upperBaseName = upperBlock.GetNameAndNameSpaceWithoutState();
-
-        bool upperIsFluid = fluidDefinitions.find(upperBaseName) != fluidDefinitions.end();
+        const BlockTraits& upperBlock = GetBlockTraits(upperId);
 
-        if (upperIsFluid || upperBlock.level == 0) {
+        if (upperBlock.isFluid || upperBlock.level == 0) {
             return 8; // 上方是流体
         }
         else {
@@ -796,25 +927,17 @@ int GetSkyLight(int blockX, int blockY, int blockZ) {
 
     int sectionY;
     blockYToSectionY(blockY, sectionY);
-    int adjustedSectionY = AdjustSectionY(sectionY);
-    auto blockKey = std::make_tuple(chunkX, chunkZ, adjustedSectionY);
-
-    auto it = sectionCache.find(blockKey);
-    if (it == sectionCache.end()) {
+    const SectionCacheEntry* section = FindOrDecodeSection(chunkX, chunkZ, AdjustSectionY(sectionY));
+    if (!section) {
         return 0; // 区块未预加载，返回默认天空光照0
     }
-    const auto& skyLightData = it->second.skyLight;
-
-    if (skyLightData.size() == 1) {
-        return skyLightData[0]; // 标记为-1或-2
-    }
-
     int relativeX = mod16(blockX);
     int relativeY = mod16(blockY);
     int relativeZ = mod16(blockZ);
     int yzx = toYZX(relativeX, relativeY, relativeZ);
 
-    return (yzx < skyLightData.size()) ? skyLightData[yzx] : 0;
+    // 没有光照数据时返回标记-1或-2
+    return section->skyLight.Get(yzx);
 }
 
 int GetBlockLight(int blockX, int blockY, int blockZ) {
@@ -823,32 +946,46 @@ int GetBlockLight(int blockX, int blockY, int blockZ) {
 
     int sectionY;
     blockYToSectionY(blockY, sectionY);
-    int adjustedSectionY = AdjustSectionY(sectionY);
-    auto blockKey = std::make_tuple(chunkX, chunkZ, adjustedSectionY);
-
-    auto it = sectionCache.find(blockKey);
-    if (it == sectionCache.end()) {
+    const SectionCacheEntry* section = FindOrDecodeSection(chunkX, chunkZ, AdjustSectionY(sectionY));
+    if (!section) {
         return 0; // 区块未预加载，返回默认方块光照0
     }
-    const auto& blockLightData = it->second.blockLight;
-
-    if (blockLightData.size() == 1) {
-        return blockLightData[0]; // 标记为-1或-2
-    }
-
     int relativeX = mod16(blockX);
     int relativeY = mod16(blockY);
     int relativeZ = mod16(blockZ);
     int yzx = toYZX(relativeX, relativeY, relativeZ);
 
-    return (yzx < blockLightData.size()) ? blockLightData[yzx] : 0;
+    // 没有光照数据时返回标记-1或-2
+    return section->blockLight.Get(yzx);
+}
+
+const Block& GetBlockById(int blockId) {
+    static const Block airBlock("minecraft:air", true);
+    if (const Block* block = BlockRegistry::Global().Get(blockId)) {
+        return *block;
+    } else {
+        return airBlock;
+    }
+}
+
+uint8_t GetBlockFlags(int blockId) {
+    return BlockRegistry::Global().Flags(blockId);
 }
 
-Block GetBlockById(int blockId) {
-    if (blockId >= 0 && blockId < globalBlockPalette.size()) {
-        return globalBlockPalette[blockId];
+const BlockTraits& GetBlockTraits(int blockId) {
+    static const BlockTraits airTraits = [] {
+        BlockTraits traits;
+        traits.namespaceName = "minecraft";
+        traits.nameWithoutState = traits.modifiedNameWithNamespace = "minecraft:air";
+        traits.modifiedName = "air";
+        traits.baseId = -1;
+        traits.flags = BLOCK_FLAG_AIR_BLOCK;
+        return traits;
+    }();
+    if (const BlockTraits* traits = BlockRegistry::Global().GetTraits(blockId)) {
+        return *traits;
     } else {
-        return Block("minecraft:air", true);
+        return airTraits;
     }
 }
 
@@ -857,10 +994,10 @@ Block GetBlockById(int blockId) {
 // 全局方块配置相关函数
 // --------------------------------------------------------------------------------
 void InitializeGlobalBlockPalette() {
-    globalBlockPalette.emplace_back(Block("minecraft:air"));
+    BlockRegistry::Global().Intern("minecraft:air");
 }
 
 std::vector<Block> GetGlobalBlockPalette() {
-    return globalBlockPalette;
+    return BlockRegistry::Global().Snapshot();
 }
 
@@ -3,6 +3,7 @@
 // C++ 标准库头文件
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cctype>
 #include <cstdint>
 #include <regex>
@@ -45,7 +46,6 @@ struct SectionCacheEntry; // 确保 SectionCacheEntry 已定义
 
 extern std::unordered_map<std::pair<int, int>, std::vector<std::shared_ptr<EntityBlock>>, pair_hash> EntityBlockCache;
 extern std::unordered_map<std::pair<int, int>, std::unordered_map<std::string, std::vector<int>>, pair_hash> heightMapCache;
-extern std::unordered_map<std::tuple<int, int, int>, SectionCacheEntry, triple_hash> sectionCache;
 
 struct Block {
     std::string name;
@@ -139,6 +139,8 @@ struct Block {
     }
     Block(const std::string& name, bool air) : name(name), level(-1), air(air) {}
 
+    // 注:以下字符串方法每次调用都会重新解析 name,热路径请使用 GetBlockTraits 中预先计算的结果
+
     // 方法:获取命名空间部分
     std::string GetNamespace() const {
         size_t colonPos = name.find(':'); // 查找第一个冒号的位置
@@ -402,20 +404,98 @@ struct Block {
     }
 };
 
+// 方块属性位,按全局ID存放在紧凑数组中(GetBlockFlags),面剔除只需位运算
+enum BlockFlag : uint8_t {
+    BLOCK_FLAG_OPAQUE      = 1 << 0, // 实心方块,遮挡相邻面(即 !Block::air)
+    BLOCK_FLAG_FLUID       = 1 << 1, // 已注册的流体方块本身
+    BLOCK_FLAG_HAS_FLUID   = 1 << 2, // 带流体数据(level != -1),包括含水方块
+    BLOCK_FLAG_WATERLOGGED = 1 << 3, // level == 0:含水方块或流体源
+    BLOCK_FLAG_AIR_BLOCK   = 1 << 4, // 名称为 minecraft:air
+};
+
+// 按全局ID预先计算的方块特征,注册时生成一次,网格生成时无需再解析方块名
+struct BlockModelRefs; // blockstate.h
+
+// 方块状态烘焙完成后发布的模型候选(指向 blockstate 模型缓存,发布后不再改变),未发布时为空
+// 可复制以便 BlockTraits 按值构造;发布与读取无锁
+class BlockModelHandle {
+public:
+    BlockModelHandle() = default;
+    BlockModelHandle(const BlockModelHandle& other) : refs(other.Get()) {}
+    BlockModelHandle& operator=(const BlockModelHandle& other) {
+        refs.store(other.Get(), std::memory_order_release);
+        return *this;
+    }
+
+    const BlockModelRefs* Get() const { return refs.load(std::memory_order_acquire); }
+    void Publish(const BlockModelRefs* value) const { refs.store(value, std::memory_order_release); }
+
+private:
+    mutable std::atomic<const BlockModelRefs*> refs{ nullptr };
+};
+
+struct BlockTraits {
+    std::string namespaceName;             // GetNamespace()
+    std::string nameWithoutState;          // GetNameAndNameSpaceWithoutState()
+    std::string modifiedName;              // GetModifiedName(),即 blockstate 模型缓存键
+    std::string modifiedNameWithNamespace; // GetModifiedNameWithNamespace()
+    int baseId = 0;                        // nameWithoutState 的编号,相同编号即同种方块
+    int8_t level = -1;                     // 流体等级,同 Block::level
+    bool air = true;                       // 非实心方块,同 Block::air
+    bool isAirBlock = true;                // 名称为 minecraft:air
+    bool isFluid = false;                  // nameWithoutState 为已注册流体
+    bool isLightBlock = false;             // 光源方块(minecraft:light 等名为 light 的方块)
+    uint8_t flags = 0;                     // BlockFlag 组合
+    BlockModelHandle model;                // 烘焙后的模型候选,由 GetBlockModelRefs(blockId) 首次查询时发布
+};
+
+// 4 位光照数组(与 NBT 中 SkyLight/BlockLight 的布局相同)
+// data 为空时整个子区块取 value:value >= 0 为统一亮度,-1 表示区块中没有该光照数据,
+// -2 表示没有数据但相邻子区块有天空光照(UpdateSkyLightNeighborFlags 设置)
+struct NibbleLight {
+    std::vector<uint8_t> data; // 2048 字节,下标 i 在第 i/2 字节,偶数下标为低 4 位
+    int8_t value = -1;
+
+    int Get(int yzx) const {
+        return data.empty() ? value : (data[yzx >> 1] >> ((yzx & 1) << 2)) & 0xF;
+    }
+    bool HasData() const { return !data.empty() || value >= 0; }
+};
+
+// 紧凑的子区块:方块以子区块调色板下标存放(调色板为全局ID),
+// 只有一种方块的子区块(全空气、全石头等)不分配下标数组
 struct SectionCacheEntry {
-    // 把频繁访问的大数组放在前面,减少访存跨缓存行
-    std::vector<int> skyLight;      // 天空光照数据
-    std::vector<int> blockLight;    // 方块光照数据
-    std::vector<int> blockData;     // 方块数据
-    std::vector<int> biomeData;     // 生物群系数据
-    std::vector<std::string> blockPalette; // 方块调色板 (相对较小)
+    std::vector<uint8_t> blockIndices;      // 4096 个调色板下标(YZX),调色板不超过 256 项时使用
+    std::vector<uint16_t> wideBlockIndices; // 调色板超过 256 项时使用
+    std::vector<int> blockPalette;          // 调色板下标 -> 全局方块ID
+    int uniformBlock = 0;                   // 两个下标数组都为空时整个子区块的方块ID
+    NibbleLight skyLight;                   // 天空光照
+    NibbleLight blockLight;                 // 方块光照
+    std::array<uint8_t, 64> biomeIndices{}; // 4x4x4 生物群系下标(16y + 4z + x)
+    std::vector<int> biomePalette;          // 生物群系下标 -> 群系ID,为空表示没有群系数据
+    std::vector<uint16_t> opaqueRows;       // 不透明方块行掩码:256 行(下标 y*16+z),第 x 位为 1 表示不透明
+    uint16_t uniformOpaqueRow = 0;          // opaqueRows 为空时所有行的掩码
+
+    int BlockAt(int yzx) const {
+        if (!blockIndices.empty()) return blockPalette[blockIndices[yzx]];
+        if (!wideBlockIndices.empty()) return blockPalette[wideBlockIndices[yzx]];
+        return uniformBlock;
+    }
+    int BiomeAt(int index) const {
+        return biomePalette.empty() ? 0 : biomePalette[biomeIndices[index]];
+    }
+    uint16_t OpaqueRow(int localY, int localZ) const {
+        return opaqueRows.empty() ? uniformOpaqueRow : opaqueRows[(localY << 4) | localZ];
+    }
 };
 
-extern std::vector<Block> globalBlockPalette;
-extern std::unordered_map<std::tuple<int, int, int>, SectionCacheEntry, triple_hash> sectionCache;
 extern std::unordered_map<std::pair<int, int>, std::unordered_map<std::string, std::vector<int>>, pair_hash> heightMapCache;
 
-// 全局读写锁:保护 sectionCache 线程安全
+// 子区块缓存,定义见 SectionStore.h
+class SectionStore;
+extern SectionStore sectionCache;
+
+// 串行化 sectionCache 的写入(读取无需加锁,见 SectionStore)
 extern std::shared_mutex sectionCacheMutex;
 
 // 保护 EntityBlockCache 与 heightMapCache 的读写
@@ -424,8 +504,13 @@ extern std::shared_mutex chunkAuxCacheMutex;
 // 高度图类型
 static const std::vector<std::string> mapTypes = {"MOTION_BLOCKING", "MOTION_BLOCKING_NO_LEAVES",   "OCEAN_FLOOR", "WORLD_SURFACE"};
 
+// 加载整个区块:只解码 config.sectionYStart-1 ~ sectionYEnd+1 范围内的子区块,
+// 其余子区块保存原始 NBT 字节,由 LoadDeferredSection 在首次查询时解码
 void LoadAndCacheBlockData(int chunkX, int chunkZ);
 
+// 解码延迟保存的子区块(cacheSectionY 为 sectionCache 键中的 Y),没有待解码数据时不做任何事
+void LoadDeferredSection(int chunkX, int chunkZ, int cacheSectionY);
+
 void UpdateSkyLightNeighborFlags();
 
 int GetBlockId(int blockX, int blockY, int blockZ);
@@ -443,8 +528,20 @@ int GetHeightMapY(int blockX, int blockZ, const std::string& heightMapType);
 
 void ClearSectionCacheForChunk(int chunkX, int chunkZ);
 
-// 获取方块名称转换为Block对象
-Block GetBlockById(int blockId);
+// 把子区块缓存的稠密网格设为当前批次的区块范围(含边界),在加载批次前调用
+void SetSectionCacheGrid(int chunkXStart, int chunkXEnd, int chunkZStart, int chunkZEnd);
+
+// 释放子区块缓存中已被替换或删除的对象,只能在没有线程读取缓存时调用(批次卸载之后)
+void ReclaimSectionCache();
+
+// 按全局ID获取方块,ID 无效时返回空气(引用在整个导出过程中保持有效)
+const Block& GetBlockById(int blockId);
+
+// 按全局ID获取预先计算的方块特征,ID 无效时返回空气的特征
+const BlockTraits& GetBlockTraits(int blockId);
+
+// 按全局ID获取方块属性位(BlockFlag),ID 无效时按空气处理
+uint8_t GetBlockFlags(int blockId);
 
 // 返回全局的block对照表(Block对象)
 std::vector<Block> GetGlobalBlockPalette();
@@ -1,6 +1,7 @@
 ﻿#include "blockstate.h"
 #include "fileutils.h"
 #include "ObjExporter.h"
+#include "ThreadPool.h"
 #include <regex>
 #include <random>
 #include <numeric>
@@ -9,13 +10,20 @@
 #include <sstream>
 #include <mutex>
 #include <shared_mutex>
+#include <algorithm>
+#include <bit>
+#include <map>
+#include <string_view>
 
-std::unordered_map<std::string, std::unordered_map<std::string, ModelData>> BlockModelCache;
+std::unordered_map<std::string, std::unordered_map<std::string, BakedModelPtr>> BlockModelCache;
 
 std::unordered_map<std::string,std::unordered_map<std::string,std::vector<WeightedModelData>>> VariantModelCache;
 
 std::unordered_map<std::string,std::unordered_map<std::string,std::vector<std::vector<WeightedModelData>>>> MultipartModelCache;
 
+// 与 MultipartModelCache 一一对应的组合缓存
+static std::unordered_map<std::string, std::unordered_map<std::string, std::unique_ptr<MultipartCombinations>>> MultipartCombinationCache;
+
 // 将互斥锁类型更改为 std::shared_mutex
 std::shared_mutex blockstateCachesMutex;
 
@@ -116,35 +124,6 @@ bool matchConditions(const std::unordered_map<std::string, std::string>& blockCo
     return false;
 }
 
-// 辅助函数:将键值对字符串解析为map
-std::unordered_map<std::string, std::string> ParseKeyValuePairs(const std::string& input) {
-    std::unordered_map<std::string, std::string> result;
-    if (input.empty()) return result;
-
-    std::stringstream ss(input);
-    std::string pair;
-    while (std::getline(ss, pair, ',')) {
-        size_t eqPos = pair.find('=');
-        if (eqPos != std::string::npos) {
-            std::string key = pair.substr(0, eqPos);
-            std::string value = pair.substr(eqPos + 1);
-            result[key] = value;
-        }
-    }
-    return result;
-}
-
-// 检查 subset 的所有键值对是否存在于 superset 中且值相同
-bool IsSubset(const std::unordered_map<std::string, std::string>& subset,const std::unordered_map<std::string, std::string>& superset) {
-    for (const auto& kv : subset) {
-        auto it = superset.find(kv.first);
-        
-        if (it == superset.end() || it->second != kv.second) {
-            return false;
-        }
-    }
-    return true;
-}
 // --------------------------------------------------------------------------------
 // 字符串分割函数
 // --------------------------------------------------------------------------------
@@ -225,57 +204,202 @@ nlohmann::json GetBlockstateJson(const std::string& namespaceName, const std::st
 // --------------------------------------------------------------------------------
 // 方块状态 JSON 处理
 // --------------------------------------------------------------------------------
-ModelData GetRandomModelFromCache(const std::string& namespaceName, const std::string& blockId) {
+MultipartCombinations::MultipartCombinations(const std::vector<std::vector<WeightedModelData>>& partList)
+    : partList(partList) {
+    // 计算所有组中模型数的最大值作为随机索引的范围
+    for (const auto& parts : partList) {
+        if (parts.size() > count) {
+            count = parts.size();
+        }
+    }
+    combinations = std::make_unique<std::atomic<const ModelData*>[]>(count);
+}
+
+const ModelData* MultipartCombinations::Get(size_t index) {
+    const ModelData* combination = combinations[index].load(std::memory_order_acquire);
+    if (combination) {
+        return combination;
+    }
+
+    std::lock_guard<std::mutex> lock(mergeMutex);
+    combination = combinations[index].load(std::memory_order_relaxed);
+    if (!combination) {
+        ModelData mergedModel;
+        for (const auto& parts : partList) {
+            size_t part = index < parts.size() ? index : 0; // 如果当前组中没有该位置的模型,则默认选第一个
+            mergedModel = MergeModelData(mergedModel, *parts[part].model);
+        }
+        merged.push_back(std::make_shared<const ModelData>(std::move(mergedModel)));
+        combination = merged.back().get();
+        combinations[index].store(combination, std::memory_order_release);
+    }
+    return combination;
+}
+
+// --------------------------------------------------------------------------------
+// 延迟烘焙
+// --------------------------------------------------------------------------------
+// 待烘焙的方块状态:claimed 保证只烘焙一次,其他线程通过 done 等待结果
+struct PendingBlockstate {
+    std::string namespaceName;
+    std::string blockId;
+    std::atomic<bool> claimed{ false };
+    std::promise<void> promise;
+    std::shared_future<void> done;
+};
+
+static std::mutex pendingBlockstatesMutex;
+static std::unordered_map<std::string, std::shared_ptr<PendingBlockstate>> pendingBlockstates; // "namespace:blockId"
+static std::vector<std::shared_ptr<PendingBlockstate>> pendingBakeQueue;                       // 登记顺序
+static std::atomic<size_t> pendingBlockstateCount{ 0 };
+
+// 烘焙(或等待其他线程烘焙)一个待处理的方块状态,返回时模型已写入缓存
+static void BakePendingBlockstate(PendingBlockstate& pending) {
+    if (!pending.claimed.exchange(true, std::memory_order_acq_rel)) {
+        try {
+            ProcessBlockstate(pending.namespaceName, { pending.blockId });
+        } catch (const std::exception& e) {
+            std::cerr << "Error in ProcessBlockstate: " << e.what() << std::endl;
+        }
+        {
+            std::lock_guard<std::mutex> lock(pendingBlockstatesMutex);
+            pendingBlockstates.erase(pending.namespaceName + ":" + pending.blockId);
+            pendingBlockstateCount.fetch_sub(1, std::memory_order_release);
+        }
+        pending.promise.set_value();
+        return;
+    }
+    pending.done.wait();
+}
+
+// 查询模型前调用:方块状态仍在等待烘焙时就地烘焙或等待
+static void WaitForPendingBlockstate(const std::string& namespaceName, const std::string& blockId) {
+    if (pendingBlockstateCount.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+    std::shared_ptr<PendingBlockstate> pending;
+    {
+        std::lock_guard<std::mutex> lock(pendingBlockstatesMutex);
+        auto it = pendingBlockstates.find(namespaceName + ":" + blockId);
+        if (it == pendingBlockstates.end()) {
+            return;
+        }
+        pending = it->second;
+    }
+    BakePendingBlockstate(*pending);
+}
+
+void QueueBlockstatesForBlocks(const std::vector<Block>& blocks) {
+    std::lock_guard<std::mutex> lock(pendingBlockstatesMutex);
+    for (const auto& block : blocks) {
+        auto pending = std::make_shared<PendingBlockstate>();
+        pending->namespaceName = block.GetNamespace();
+        pending->blockId = block.GetModifiedName();
+        pending->done = pending->promise.get_future().share();
+        if (pendingBlockstates.try_emplace(pending->namespaceName + ":" + pending->blockId, pending).second) {
+            pendingBakeQueue.push_back(std::move(pending));
+            pendingBlockstateCount.fetch_add(1, std::memory_order_release);
+        }
+    }
+}
+
+void BakePendingBlockstates() {
+    std::vector<std::shared_ptr<PendingBlockstate>> queue;
+    {
+        std::lock_guard<std::mutex> lock(pendingBlockstatesMutex);
+        queue.swap(pendingBakeQueue);
+    }
+    if (queue.empty()) {
+        return;
+    }
+    ThreadPool::Loader().ParallelFor(queue.size(), [&](size_t index) {
+        BakePendingBlockstate(*queue[index]);
+    });
+}
+
+BlockModelRefs GetBlockModelRefs(const std::string& namespaceName, const std::string& blockId) {
+    WaitForPendingBlockstate(namespaceName, blockId);
     std::shared_lock<std::shared_mutex> lock(blockstateCachesMutex); // 使用 shared_lock 进行读操作
+    BlockModelRefs refs;
+    auto blockNs = BlockModelCache.find(namespaceName);
+    if (blockNs != BlockModelCache.end()) {
+        auto it = blockNs->second.find(blockId);
+        if (it != blockNs->second.end()) {
+            refs.model = it->second.get();
+        }
+    }
+    auto variantNs = VariantModelCache.find(namespaceName);
+    if (variantNs != VariantModelCache.end()) {
+        auto it = variantNs->second.find(blockId);
+        if (it != variantNs->second.end()) {
+            refs.variants = &it->second;
+            for (const auto& wm : it->second) {
+                refs.totalWeight += wm.weight;
+            }
+        }
+    }
+    auto multipartNs = MultipartCombinationCache.find(namespaceName);
+    if (multipartNs != MultipartCombinationCache.end()) {
+        auto it = multipartNs->second.find(blockId);
+        if (it != multipartNs->second.end()) {
+            refs.multipart = it->second.get();
+        }
+    }
+    return refs;
+}
+
+// 已发布到 BlockTraits::model 的模型候选,导出期间只增不删
+static std::vector<std::unique_ptr<const BlockModelRefs>> publishedModelRefs;
+static std::mutex publishedModelRefsMutex;
+
+const BlockModelRefs& GetBlockModelRefs(int blockId) {
+    const BlockTraits& traits = GetBlockTraits(blockId);
+    if (const BlockModelRefs* refs = traits.model.Get()) {
+        return *refs;
+    }
+    // 等待该状态烘焙完成后再发布:模型缓存条目一经写入不再替换,发布的候选之后不会变化
+    auto refs = std::make_unique<const BlockModelRefs>(GetBlockModelRefs(traits.namespaceName, traits.modifiedName));
+    std::lock_guard<std::mutex> lock(publishedModelRefsMutex);
+    if (const BlockModelRefs* published = traits.model.Get()) {
+        return *published;
+    }
+    publishedModelRefs.push_back(std::move(refs));
+    traits.model.Publish(publishedModelRefs.back().get());
+    return *publishedModelRefs.back();
+}
+
+const ModelData* PickRandomModel(const BlockModelRefs& refs) {
     // 先检查主缓存
-    if (BlockModelCache.count(namespaceName) &&
-        BlockModelCache[namespaceName].count(blockId)) {
-        return BlockModelCache[namespaceName][blockId];
+    if (refs.model) {
+        return refs.model;
     }
-    
+
     // 检查 variant 缓存
-    if (VariantModelCache.count(namespaceName) &&
-        VariantModelCache[namespaceName].count(blockId)) {
-        auto& models = VariantModelCache[namespaceName][blockId];
-        int totalWeight = 0;
-        for (const auto& wm : models) {
-            totalWeight += wm.weight;
-        }
-
-        if (totalWeight > 0) {
-            if (config.useRandomBlockModels) {
-                thread_local static std::mt19937 gen(std::random_device{}()); // 使用 thread_local 随机数生成器
-                std::uniform_int_distribution<> dis(1, totalWeight);
-                int randomWeight = dis(gen);
-                int cumulative = 0;
-                for (const auto& wm : models) {
-                    cumulative += wm.weight;
-                    if (randomWeight <= cumulative) {
-                        return wm.model;
-                    }
+    if (refs.variants && refs.totalWeight > 0) {
+        const auto& models = *refs.variants;
+        if (config.useRandomBlockModels) {
+            thread_local static std::mt19937 gen(std::random_device{}()); // 使用 thread_local 随机数生成器
+            std::uniform_int_distribution<> dis(1, refs.totalWeight);
+            int randomWeight = dis(gen);
+            int cumulative = 0;
+            for (const auto& wm : models) {
+                cumulative += wm.weight;
+                if (randomWeight <= cumulative) {
+                    return wm.model.get();
                 }
-            } else {
-                // 当禁用随机时，总是返回第一个模型
-                return models[0].model;
             }
+        } else {
+            // 当禁用随机时，总是返回第一个模型
+            return models[0].model.get();
         }
     }
 
     // 检查 multipart 缓存:在 multipart 时只进行一次随机,
     // 对每个组选取对应位置的模型(如果该位置没有则使用第一个)
-    if (MultipartModelCache.count(namespaceName) &&
-        MultipartModelCache[namespaceName].count(blockId)) {
-        auto& partList = MultipartModelCache[namespaceName][blockId];
-
-        // 计算所有组中模型数的最大值作为随机索引的范围
-        size_t maxCount = 0;
-        for (const auto& parts : partList) {
-            if (parts.size() > maxCount) {
-                maxCount = parts.size();
-            }
-        }
+    if (refs.multipart) {
+        size_t maxCount = refs.multipart->Count();
         if (maxCount == 0) {
-            return ModelData();
+            return nullptr;
         }
 
         int selectedIndex = 0;
@@ -284,154 +408,443 @@ ModelData GetRandomModelFromCache(const std::string& namespaceName, const std::s
             std::uniform_int_distribution<> dis(0, maxCount - 1);
             selectedIndex = dis(gen_multi);
         }
+        return refs.multipart->Get(selectedIndex);
+    }
+
+    return nullptr;
+}
+
+ModelData GetRandomModelFromCache(const std::string& namespaceName, const std::string& blockId) {
+    const ModelData* model = PickRandomModel(GetBlockModelRefs(namespaceName, blockId));
+    // 返回空模型
+    return model ? *model : ModelData();
+}
+
+// --------------------------------------------------------------------------------
+// 编译后的方块状态
+// --------------------------------------------------------------------------------
+// 遍历 "key=value,key=value" 中的键值对(与 SortedVariantKey 的解析规则一致,不合法的片段被忽略)
+template <typename Fn>
+static void ForEachKeyValue(std::string_view input, Fn&& fn) {
+    while (!input.empty()) {
+        size_t comma = input.find(',');
+        std::string_view part = input.substr(0, comma);
+        size_t eqPos = part.find('=');
+        if (eqPos != std::string_view::npos && eqPos > 0 && eqPos + 1 < part.size()) {
+            fn(part.substr(0, eqPos), part.substr(eqPos + 1));
+        }
+        if (comma == std::string_view::npos) break;
+        input.remove_prefix(comma + 1);
+    }
+}
 
-        ModelData merged;
-        for (auto& parts : partList) {
-            int index = selectedIndex;
-            if (index >= parts.size()) {
-                index = 0; // 如果当前组中没有该位置的模型,则默认选第一个
+// 方块状态 JSON 只编译一次:属性名与属性值映射为小整数,方块状态压缩为一个 64 位整数,
+// variants 按要求的属性(掩码)分组,以压缩后的属性值建表,匹配 variant 只需整数运算和一次哈希查找
+struct CompiledBlockstate {
+    // multipart 的 when 条件编译为对属性值编号的判断,不再访问 JSON 或比较字符串
+    // 单个属性条件:属性存在,且取值编号在 accepted 位集中(invert 时不在)
+    struct Clause {
+        uint32_t property = 0;
+        bool invert = false;
+        std::vector<uint64_t> accepted;
+
+        bool Evaluate(const std::vector<uint32_t>& state) const {
+            uint32_t value = state[property];
+            if (value == 0) return false; // 缺少属性时即使是反转条件也不匹配
+            size_t word = value >> 6;
+            bool matched = word < accepted.size() && ((accepted[word] >> (value & 63)) & 1);
+            return matched != invert;
+        }
+    };
+
+    // 条件树:嵌套的 AND/OR 在编译时展平,常量子条件被消去
+    struct Predicate {
+        enum class Kind : uint8_t { Always, Never, All, Any };
+        Kind kind = Kind::Always;
+        std::vector<Clause> clauses;      // All:所有子句都满足
+        std::vector<Predicate> children;  // All:所有子条件都满足;Any:任一子条件满足
+
+        bool Evaluate(const std::vector<uint32_t>& state) const {
+            switch (kind) {
+            case Kind::Always: return true;
+            case Kind::Never:  return false;
+            case Kind::All:
+                for (const Clause& clause : clauses) {
+                    if (!clause.Evaluate(state)) return false;
+                }
+                for (const Predicate& child : children) {
+                    if (!child.Evaluate(state)) return false;
+                }
+                return true;
+            case Kind::Any:
+                for (const Predicate& child : children) {
+                    if (child.Evaluate(state)) return true;
+                }
+                return false;
             }
-            merged = MergeModelData(merged, parts[index].model);
+            return false;
         }
-        return merged;
+    };
+
+    struct MultipartPart {
+        const nlohmann::json* item = nullptr;
+        Predicate when; // 没有 when 时为 Always
+    };
+
+    struct Variant {
+        const nlohmann::json* value = nullptr;
+        std::vector<std::pair<uint32_t, uint32_t>> requirements; // (属性编号, 值编号)
+        uint64_t mask = 0;
+        uint64_t packed = 0;
+    };
+
+    nlohmann::json json;
+    std::unordered_map<std::string, uint32_t> propertyIds;
+    // 每个属性的取值编号,从 2 开始;0 表示方块状态中缺少该属性,1 表示取值未在 JSON 中出现
+    std::vector<std::unordered_map<std::string, uint32_t>> propertyValues;
+    std::vector<uint32_t> fieldShift;
+    bool packable = true; // 所有属性能放进 64 位,否则逐条比较 requirements
+    std::vector<Variant> variants; // JSON 顺序
+    std::vector<std::pair<uint64_t, std::unordered_map<uint64_t, std::vector<uint32_t>>>> variantTables;
+    std::vector<MultipartPart> multipartParts; // JSON 顺序
+
+    uint32_t InternProperty(std::string_view name) {
+        auto [it, inserted] = propertyIds.try_emplace(std::string(name), static_cast<uint32_t>(propertyValues.size()));
+        if (inserted) propertyValues.emplace_back();
+        return it->second;
+    }
+    uint32_t InternValue(uint32_t property, std::string_view value) {
+        auto& values = propertyValues[property];
+        return values.try_emplace(std::string(value), static_cast<uint32_t>(values.size() + 2)).first->second;
     }
 
-    // 返回空模型
-    return ModelData();
+    // 编译 when 条件,规则与 matchConditions 相同
+    Predicate CompileWhen(const nlohmann::json& when) {
+        Predicate predicate;
+        if (when.is_null()) {
+            return predicate; // 当条件不存在时默认匹配
+        }
+        predicate.kind = Predicate::Kind::Never;
+        if (!when.is_object() || when.empty()) {
+            return predicate; // 非对象/null类型无效,空对象不匹配
+        }
+
+        if (when.size() == 1 && (when.contains("OR") || when.contains("AND"))) {
+            const bool isOr = when.contains("OR");
+            const auto& list = when[isOr ? "OR" : "AND"];
+            if (!list.is_array()) {
+                return predicate;
+            }
+            Predicate combined;
+            combined.kind = isOr ? Predicate::Kind::Any : Predicate::Kind::All;
+            for (const auto& cond : list) {
+                Predicate child = CompileWhen(cond);
+                if (isOr) {
+                    if (child.kind == Predicate::Kind::Always) return child;
+                    if (child.kind == Predicate::Kind::Never) continue;
+                    if (child.kind == Predicate::Kind::Any) {
+                        for (auto& grandchild : child.children) combined.children.push_back(std::move(grandchild));
+                    } else {
+                        combined.children.push_back(std::move(child));
+                    }
+                } else {
+                    if (child.kind == Predicate::Kind::Never) return child;
+                    if (child.kind == Predicate::Kind::Always) continue;
+                    if (child.kind == Predicate::Kind::All) {
+                        for (auto& clause : child.clauses) combined.clauses.push_back(std::move(clause));
+                        for (auto& grandchild : child.children) combined.children.push_back(std::move(grandchild));
+                    } else {
+                        combined.children.push_back(std::move(child));
+                    }
+                }
+            }
+            if (isOr) {
+                if (combined.children.empty()) return predicate;
+                if (combined.children.size() == 1) return std::move(combined.children[0]);
+            } else if (combined.clauses.empty() && combined.children.empty()) {
+                combined.kind = Predicate::Kind::Always;
+            }
+            return combined;
+        }
+
+        // 普通多条件:每个属性一个子句
+        Predicate all;
+        all.kind = Predicate::Kind::All;
+        for (const auto& item : when.items()) {
+            if (!item.value().is_string()) {
+                return predicate;
+            }
+            std::string_view valueStr = item.value().get_ref<const std::string&>();
+            Clause clause;
+            if (!valueStr.empty() && valueStr[0] == '!') {
+                clause.invert = true;
+                valueStr.remove_prefix(1);
+            }
+            if (valueStr.empty()) {
+                return predicate; // 空属性值
+            }
+            clause.property = InternProperty(item.key());
+            while (true) {
+                size_t bar = valueStr.find('|');
+                uint32_t value = InternValue(clause.property, valueStr.substr(0, bar));
+                if (clause.accepted.size() <= (value >> 6)) clause.accepted.resize((value >> 6) + 1, 0);
+                clause.accepted[value >> 6] |= uint64_t{ 1 } << (value & 63);
+                if (bar == std::string_view::npos) break;
+                valueStr.remove_prefix(bar + 1);
+            }
+            all.clauses.push_back(std::move(clause));
+        }
+        return all;
+    }
+
+    // 编译:登记属性与取值,编译 multipart 条件,分配位域并建立 variant 表
+    void Compile() {
+        if (json.is_object() && json.contains("multipart")) {
+            for (const auto& item : json["multipart"]) {
+                MultipartPart part;
+                part.item = &item;
+                if (item.is_object() && item.contains("when")) {
+                    part.when = CompileWhen(item["when"]);
+                }
+                multipartParts.push_back(std::move(part));
+            }
+        }
+
+        if (json.is_object() && json.contains("variants") && json["variants"].is_object()) {
+            for (const auto& item : json["variants"].items()) {
+                Variant variant;
+                variant.value = &item.value();
+                // 同一属性出现多次时以最后一次为准(与 SortedVariantKey 一致)
+                std::map<uint32_t, uint32_t> requirements;
+                ForEachKeyValue(item.key(), [&](std::string_view name, std::string_view value) {
+                    uint32_t property = InternProperty(name);
+                    requirements[property] = InternValue(property, value);
+                });
+                variant.requirements.assign(requirements.begin(), requirements.end());
+                variants.push_back(std::move(variant));
+            }
+        }
+
+        uint32_t shift = 0;
+        for (const auto& values : propertyValues) {
+            fieldShift.push_back(shift);
+            shift += std::bit_width(values.size() + 1);
+        }
+        packable = shift <= 64;
+        if (!packable) return;
+
+        for (uint32_t i = 0; i < variants.size(); ++i) {
+            Variant& variant = variants[i];
+            for (const auto& [property, value] : variant.requirements) {
+                uint64_t fieldMask = ((uint64_t{ 1 } << std::bit_width(propertyValues[property].size() + 1)) - 1) << fieldShift[property];
+                variant.mask |= fieldMask;
+                variant.packed |= static_cast<uint64_t>(value) << fieldShift[property];
+            }
+            auto table = std::find_if(variantTables.begin(), variantTables.end(),
+                [&](const auto& entry) { return entry.first == variant.mask; });
+            if (table == variantTables.end()) {
+                variantTables.emplace_back(variant.mask, std::unordered_map<uint64_t, std::vector<uint32_t>>());
+                table = variantTables.end() - 1;
+            }
+            table->second[variant.packed].push_back(i);
+        }
+    }
+
+    // 方块状态 "key=value,..." 中每个属性的取值编号
+    std::vector<uint32_t> EncodeState(std::string_view condition) const {
+        std::vector<uint32_t> state(propertyValues.size(), 0);
+        ForEachKeyValue(condition, [&](std::string_view name, std::string_view value) {
+            auto property = propertyIds.find(std::string(name));
+            if (property == propertyIds.end()) return;
+            auto valueIt = propertyValues[property->second].find(std::string(value));
+            state[property->second] = valueIt != propertyValues[property->second].end() ? valueIt->second : 1;
+        });
+        return state;
+    }
+
+    // 与方块状态匹配的 variant 下标(按 JSON 顺序):variant 要求的属性值都存在于方块状态中
+    void MatchVariants(const std::vector<uint32_t>& state, std::vector<uint32_t>& matches) const {
+        if (packable) {
+            uint64_t packed = 0;
+            for (size_t property = 0; property < state.size(); ++property) {
+                packed |= static_cast<uint64_t>(state[property]) << fieldShift[property];
+            }
+            for (const auto& [mask, table] : variantTables) {
+                auto it = table.find(packed & mask);
+                if (it != table.end()) {
+                    matches.insert(matches.end(), it->second.begin(), it->second.end());
+                }
+            }
+            std::sort(matches.begin(), matches.end());
+            return;
+        }
+        for (uint32_t i = 0; i < variants.size(); ++i) {
+            bool matched = true;
+            for (const auto& [property, value] : variants[i].requirements) {
+                matched = matched && state[property] == value;
+            }
+            if (matched) matches.push_back(i);
+        }
+    }
+};
+
+static std::unordered_map<std::string, std::shared_ptr<const CompiledBlockstate>> compiledBlockstates;
+static std::shared_mutex compiledBlockstatesMutex;
+
+// 获取编译后的方块状态,JSON 不存在时 json 为 null
+static std::shared_ptr<const CompiledBlockstate> GetCompiledBlockstate(const std::string& namespaceName, const std::string& baseBlockId) {
+    std::string key = namespaceName + ":" + baseBlockId;
+    {
+        std::shared_lock<std::shared_mutex> lock(compiledBlockstatesMutex);
+        auto it = compiledBlockstates.find(key);
+        if (it != compiledBlockstates.end()) {
+            return it->second;
+        }
+    }
+
+    // 在锁外读取并编译,多个线程同时编译同一方块时保留先登记的结果
+    auto compiled = std::make_shared<CompiledBlockstate>();
+    compiled->json = GetBlockstateJson(namespaceName, baseBlockId);
+    compiled->Compile();
+
+    std::unique_lock<std::shared_mutex> lock(compiledBlockstatesMutex);
+    return compiledBlockstates.try_emplace(std::move(key), std::move(compiled)).first->second;
 }
 
 // 此方法会处理对应的json文件 
 // 然后计算出方块的模型数据存储在BlockModelCache / VariantModelCache / MultipartModelCache 里面
 // 你可以使用 GetRandomModelFromCache 方法来获取模型
 void ProcessBlockstate(const std::string& namespaceName, const std::vector<std::string>& blockIds) {
+    std::vector<uint32_t> matchedVariants;
     for (const auto& blockId : blockIds) {
-        // 解析 blockId 和条件
-        static const std::regex blockIdRegex(R"(^(.*?)\[(.*)\]$)");
-        std::smatch match;
+        // 解析 blockId 和条件:name[key=value,...]
         std::string baseBlockId = blockId;
         std::string condition;
-        std::unordered_map<std::string, std::string> blockConditions;
         std::string blockstateName = namespaceName + ":" + blockId;
 
-        if (std::regex_match(blockId, match, blockIdRegex)) {
-            baseBlockId = match.str(1);
-            condition = match.str(2);
-
-            static const std::regex conditionRegex(R"((\w+)=([^,]+))");
-            auto conditionsBegin = std::sregex_iterator(condition.begin(), condition.end(), conditionRegex);
-            auto conditionsEnd = std::sregex_iterator();
-
-            for (auto i = conditionsBegin; i != conditionsEnd; ++i) {
-                std::smatch submatch = *i;
-                blockConditions[submatch[1].str()] = submatch[2].str();
-            }
+        size_t bracketPos = blockId.find('[');
+        if (bracketPos != std::string::npos && blockId.back() == ']') {
+            baseBlockId = blockId.substr(0, bracketPos);
+            condition = blockId.substr(bracketPos + 1, blockId.size() - bracketPos - 2);
         }
 
-        // 读取 blockstate JSON
-        nlohmann::json blockstateJson = GetBlockstateJson(namespaceName, baseBlockId);
-
+        // 读取编译后的 blockstate(每个方块只编译一次)
+        std::shared_ptr<const CompiledBlockstate> compiled = GetCompiledBlockstate(namespaceName, baseBlockId);
+        const nlohmann::json& blockstateJson = compiled->json;
 
         if (blockstateJson.is_null()) {
             continue;
         }
+        const std::vector<uint32_t> state = compiled->EncodeState(condition);
 
         ModelData mergedModel;
         std::vector<ModelData> selectedModels;
 
-        // 处理 variants
+        // 处理 variants:没有状态时所有 variant 都匹配,否则 variant 要求的属性值需全部存在于方块状态中
         if (blockstateJson.contains("variants")) {
-            for (auto& variant : blockstateJson["variants"].items()) {
-                std::string variantKey = variant.key();
-                std::string normalizedCondition = SortedVariantKey(condition);
-                std::string normalizedVariantKey = SortedVariantKey(variantKey);
-
-                // 解析为键值对
-                auto conditionMap = ParseKeyValuePairs(normalizedCondition);
-                auto variantMap = ParseKeyValuePairs(normalizedVariantKey);
-
-                // 判断条件:variantMap 的所有键值对需存在于 conditionMap 中
-                if (condition.empty() || IsSubset(variantMap, conditionMap)) {
-                    int rotationX = 0, rotationY = 0;
-                    bool uvlock = false;
-
-
-                    if (variant.value().contains("x")) {
-                        rotationX = variant.value()["x"].get<int>();
-                        rotationX = (rotationX % 360 + 360) % 360; 
-                    }
-                    if (variant.value().contains("y")) {
-                        rotationY = variant.value()["y"].get<int>();
-                        rotationY = (rotationY % 360 + 360) % 360;
-                    }
-                    if (variant.value().contains("uvlock")) {
-                        uvlock = variant.value()["uvlock"].get<bool>();
-                    }
-
-                    // 处理模型加权数组
-                    if (variant.value().is_array()) {
-                        std::vector<WeightedModelData> weightedModels;
-                        std::string cacheKey = namespaceName + ":" + baseBlockId + ":" + variantKey;
-                        ModelData model;
-                        int t = 0;
-                        for (const auto& item : variant.value()) {
-                            int rotationX = 0, rotationY = 0;
-                            bool uvlock = false;
-                            if (item.contains("x")) {
-                                rotationX = item["x"].get<int>();
-                            }
-                            if (item.contains("y")) {
-                                rotationY = item["y"].get<int>();
-                            }
-                            if (item.contains("uvlock")) {
-                                uvlock = item["uvlock"].get<bool>();
-                            }
-
-                            int weight = item.contains("weight") ? item["weight"].get<int>() : 1;
-                            std::string modelId = item.contains("model") ? item["model"].get<std::string>() : "";
-
-                            if (!modelId.empty()) {
-                                // 处理模型命名空间
-                                size_t colonPos = modelId.find(':');
-                                std::string modelNamespace = namespaceName;
-                                if (colonPos != std::string::npos) {
-                                    modelNamespace = modelId.substr(0, colonPos);
-                                    modelId = modelId.substr(colonPos + 1);
-                                }
+            matchedVariants.clear();
+            if (condition.empty()) {
+                for (uint32_t i = 0; i < compiled->variants.size(); ++i) {
+                    matchedVariants.push_back(i);
+                }
+            } else {
+                compiled->MatchVariants(state, matchedVariants);
+            }
+            // 多个 variant 匹配时(例如没有状态)每个缓存保留最后一个匹配项:
+            // 先选出最后一个加权数组与最后一个带模型的 variant,只烘焙并发布这两个
+            const nlohmann::json* lastArray = nullptr;
+            const nlohmann::json* lastSingle = nullptr;
+            for (uint32_t variantIndex : matchedVariants) {
+                const nlohmann::json& variantValue = *compiled->variants[variantIndex].value;
+                if (variantValue.is_array()) {
+                    lastArray = &variantValue;
+                } else if (variantValue.contains("model") && !variantValue["model"].get<std::string>().empty()) {
+                    lastSingle = &variantValue;
+                }
+            }
+            for (const nlohmann::json* selectedVariant : { lastArray, lastSingle }) {
+                if (!selectedVariant) continue;
+                const nlohmann::json& variantValue = *selectedVariant;
+                int rotationX = 0, rotationY = 0;
+                bool uvlock = false;
 
-                                // 生成模型数据
-                                model = ProcessModelJson(modelNamespace, modelId,
-                                    rotationX, rotationY, uvlock, t, blockstateName);
 
-                                weightedModels.push_back({ model, weight });
-                                t = t + 1;
-                            }
+                if (variantValue.contains("x")) {
+                    rotationX = variantValue["x"].get<int>();
+                    rotationX = (rotationX % 360 + 360) % 360; 
+                }
+                if (variantValue.contains("y")) {
+                    rotationY = variantValue["y"].get<int>();
+                    rotationY = (rotationY % 360 + 360) % 360;
+                }
+                if (variantValue.contains("uvlock")) {
+                    uvlock = variantValue["uvlock"].get<bool>();
+                }
 
+                // 处理模型加权数组
+                if (variantValue.is_array()) {
+                    std::vector<WeightedModelData> weightedModels;
+                    ModelData model;
+                    int t = 0;
+                    for (const auto& item : variantValue) {
+                        int rotationX = 0, rotationY = 0;
+                        bool uvlock = false;
+                        if (item.contains("x")) {
+                            rotationX = item["x"].get<int>();
                         }
-                        // 存入缓存
-                        {
-                            std::unique_lock<std::shared_mutex> lock(blockstateCachesMutex); // 使用 unique_lock 进行写操作
-                            VariantModelCache[namespaceName][blockId] = weightedModels;
+                        if (item.contains("y")) {
+                            rotationY = item["y"].get<int>();
+                        }
+                        if (item.contains("uvlock")) {
+                            uvlock = item["uvlock"].get<bool>();
                         }
-                        continue;
 
-                    }
-                    else {
-                        std::string modelId = variant.value().contains("model") ? variant.value()["model"].get<std::string>() : "";
+                        int weight = item.contains("weight") ? item["weight"].get<int>() : 1;
+                        std::string modelId = item.contains("model") ? item["model"].get<std::string>() : "";
+
                         if (!modelId.empty()) {
+                            // 处理模型命名空间
                             size_t colonPos = modelId.find(':');
                             std::string modelNamespace = namespaceName;
-
                             if (colonPos != std::string::npos) {
                                 modelNamespace = modelId.substr(0, colonPos);
                                 modelId = modelId.substr(colonPos + 1);
                             }
 
-                            mergedModel = ProcessModelJson(modelNamespace, modelId, rotationX, rotationY, uvlock, 0, blockstateName);
-                           
-                            {
-                                std::unique_lock<std::shared_mutex> lock(blockstateCachesMutex); // 使用 unique_lock 进行写操作
-                                BlockModelCache[namespaceName][blockId] = mergedModel;
-                            }
+                            // 生成模型数据
+                            model = ProcessModelJson(modelNamespace, modelId,
+                                rotationX, rotationY, uvlock, t, blockstateName);
+
+                            weightedModels.push_back({ std::make_shared<const ModelData>(std::move(model)), weight });
+                            t = t + 1;
+                        }
+
+                    }
+                    // 存入缓存
+                    {
+                        std::unique_lock<std::shared_mutex> lock(blockstateCachesMutex); // 使用 unique_lock 进行写操作
+                        // 已发布的模型保持不变:网格生成线程可能持有其中的指针
+                        VariantModelCache[namespaceName].try_emplace(blockId, std::move(weightedModels));
+                    }
+                    continue;
+
+                }
+                else {
+                    std::string modelId = variantValue.contains("model") ? variantValue["model"].get<std::string>() : "";
+                    if (!modelId.empty()) {
+                        size_t colonPos = modelId.find(':');
+                        std::string modelNamespace = namespaceName;
+
+                        if (colonPos != std::string::npos) {
+                            modelNamespace = modelId.substr(0, colonPos);
+                            modelId = modelId.substr(colonPos + 1);
+                        }
+
+                        mergedModel = ProcessModelJson(modelNamespace, modelId, rotationX, rotationY, uvlock, 0, blockstateName);
+                       
+                        {
+                            std::unique_lock<std::shared_mutex> lock(blockstateCachesMutex); // 使用 unique_lock 进行写操作
+                            BlockModelCache[namespaceName].try_emplace(blockId, std::make_shared<const ModelData>(std::move(mergedModel)));
                         }
                     }
                 }
@@ -441,7 +854,7 @@ void ProcessBlockstate(const std::string& namespaceName, const std::vector<std::
 
         // 处理 multipart
         if (blockstateJson.contains("multipart")) {
-            auto multipart = blockstateJson["multipart"];
+            const auto& multipart = blockstateJson["multipart"];
             bool useMultipartModelCache = false;
             // 第一次遍历:检测是否存在列表格式的 apply
             for (const auto& item : multipart) {
@@ -454,14 +867,11 @@ void ProcessBlockstate(const std::string& namespaceName, const std::vector<std::
             if (useMultipartModelCache) {
                 // 存储所有 multipart 项的模型组,每项都作为列表处理
                 std::vector<std::vector<WeightedModelData>> multipartModelsList;
-                for (const auto& item : multipart) {
+                for (const auto& part : compiled->multipartParts) {
+                    const auto& item = *part.item;
                     if (!item.contains("apply"))
                         continue;
-                    bool conditionMatched = true;
-                    if (item.contains("when")) {
-                        conditionMatched = matchConditions(blockConditions, item["when"]);
-                    }
-                    if (!conditionMatched)
+                    if (!part.when.Evaluate(state))
                         continue;
 
                     std::vector<WeightedModelData> multipartModels;
@@ -493,13 +903,13 @@ void ProcessBlockstate(const std::string& namespaceName, const std::vector<std::
                                 // 生成模型数据
                                 ModelData model = ProcessModelJson(modelNamespace, modelId,
                                     rotationX, rotationY, uvlock, t, blockstateName);
-                                multipartModels.push_back({ model, weight });
+                                multipartModels.push_back({ std::make_shared<const ModelData>(std::move(model)), weight });
                                 ++t;
                             }
                         }
                     }
                     else if (item["apply"].is_object()) {
-                        auto apply = item["apply"];
+                        const auto& apply = item["apply"];
                         int rotationX = 0, rotationY = 0;
                         bool uvlock = false;
                         if (apply.contains("x")) {
@@ -521,7 +931,7 @@ void ProcessBlockstate(const std::string& namespaceName, const std::vector<std::
                                 modelId = modelId.substr(colonPos + 1);
                             }
                             ModelData model = ProcessModelJson(modelNamespace, modelId, rotationX, rotationY, uvlock, t, blockstateName);
-                            multipartModels.push_back({ model, weight });
+                            multipartModels.push_back({ std::make_shared<const ModelData>(std::move(model)), weight });
                         }
                     }
 
@@ -532,23 +942,23 @@ void ProcessBlockstate(const std::string& namespaceName, const std::vector<std::
                 // 存入 MultipartModelCache
                 {
                     std::unique_lock<std::shared_mutex> lock(blockstateCachesMutex); // 使用 unique_lock 进行写操作
-                    MultipartModelCache[namespaceName][blockId] = multipartModelsList;
+                    auto [partList, inserted] = MultipartModelCache[namespaceName].try_emplace(blockId, std::move(multipartModelsList));
+                    if (inserted) {
+                        MultipartCombinationCache[namespaceName][blockId] = std::make_unique<MultipartCombinations>(partList->second);
+                    }
                 }
             }
             else {
                 // 如果所有 apply 均为对象,则按照原来的逻辑处理,合并模型后存入 BlockModelCache
                 std::vector<ModelData> selectedModels;
-                for (const auto& item : multipart) {
+                for (const auto& part : compiled->multipartParts) {
+                    const auto& item = *part.item;
                     if (!item.contains("apply"))
                         continue;
-                    bool conditionMatched = true;
-                    if (item.contains("when")) {
-                        conditionMatched = matchConditions(blockConditions, item["when"]);
-                    }
-                    if (!conditionMatched)
+                    if (!part.when.Evaluate(state))
                         continue;
 
-                    auto apply = item["apply"];
+                    const auto& apply = item["apply"];
                     int rotationX = 0, rotationY = 0;
                     bool uvlock = false;
                     if (apply.contains("x")) {
@@ -581,7 +991,7 @@ void ProcessBlockstate(const std::string& namespaceName, const std::vector<std::
                 }
                 {
                     std::unique_lock<std::shared_mutex> lock(blockstateCachesMutex); // 使用 unique_lock 进行写操作
-                    BlockModelCache[namespaceName][blockId] = mergedModel;
+                    BlockModelCache[namespaceName].try_emplace(blockId, std::make_shared<const ModelData>(std::move(mergedModel)));
                 }
             }
         }
@@ -590,23 +1000,3 @@ void ProcessBlockstate(const std::string& namespaceName, const std::vector<std::
     }
 }
 
-void ProcessBlockstateForBlocks(const std::vector<Block>& blocks) {
-    std::unordered_map<std::string, std::vector<std::string>> namespaceToBlockIdsMap;
-
-    // 将 Block 列表按命名空间分组
-    for (const auto& block : blocks) {
-        std::string namespaceName = block.GetNamespace(); // 使用 Block 结构体的 GetNamespace 方法
-        std::string blockId = block.GetModifiedName();
-        namespaceToBlockIdsMap[namespaceName].push_back(blockId);
-    }
-
-    // 处理每个命名空间下的方块 ID
-    for (const auto& entry : namespaceToBlockIdsMap) {
-        const std::string& namespaceName = entry.first;
-        const std::vector<std::string>& blockIds = entry.second;
-
-        ProcessBlockstate(namespaceName, blockIds);
-       
-    }
-
-}
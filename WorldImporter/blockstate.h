@@ -13,16 +13,21 @@
 #include "config.h"
 #include "JarReader.h"
 #include "GlobalCache.h"
+#include <atomic>
 #include <future>
+#include <memory>
 #include <mutex>
 
+// 烘焙后的方块模型只读共享:缓存只保存一份,查询返回指针,网格生成时再平移输出
+using BakedModelPtr = std::shared_ptr<const ModelData>;
+
 struct WeightedModelData {
-    ModelData model;
+    BakedModelPtr model;
     int weight;
 };
 
 // 全局缓存,键为 namespace,值为 blockId 到 ModelData 的映射
-extern  std::unordered_map<std::string, std::unordered_map<std::string, ModelData>> BlockModelCache;
+extern  std::unordered_map<std::string, std::unordered_map<std::string, BakedModelPtr>> BlockModelCache;
 
 extern std::unordered_map<std::string,
     std::unordered_map<std::string,
@@ -41,11 +46,50 @@ std::string SortedVariantKey(const std::string& key);
 // --------------------------------------------------------------------------------
 void ProcessBlockstate(const std::string& namespaceName,const std::vector<std::string>& blockIds);
 
-void ProcessBlockstateForBlocks(const std::vector<Block>& blocks);
+// 延迟烘焙:加载阶段只登记新发现的方块状态,不处理模型
+void QueueBlockstatesForBlocks(const std::vector<Block>& blocks);
+
+// 在加载与网格生成之间调用,用加载线程池并行烘焙所有已登记的方块状态
+// 每个状态单独完成:烘焙前查询其模型(GetBlockModelRefs)的线程会就地烘焙或等待该状态
+void BakePendingBlockstates();
 
 // 获取方块状态 JSON 文件内容
 nlohmann::json GetBlockstateJson(const std::string& namespaceName,const std::string& blockId);
 
+// multipart 方块状态按随机索引合并好的模型组合:
+// 第 i 个组合为每组取第 i 个部件(该组没有则取第一个)合并的结果,首次使用时合并一次,之后只读取指针
+class MultipartCombinations {
+public:
+    MultipartCombinations(const std::vector<std::vector<WeightedModelData>>& partList);
+
+    size_t Count() const { return count; }
+    const ModelData* Get(size_t index);
+
+private:
+    const std::vector<std::vector<WeightedModelData>>& partList;
+    size_t count = 0; // 所有组中模型数的最大值,即随机索引的范围
+    std::unique_ptr<std::atomic<const ModelData*>[]> combinations;
+    std::vector<BakedModelPtr> merged; // 持有已合并的组合
+    std::mutex mergeMutex;
+};
+
+// 一个方块状态在模型缓存中的全部候选模型(按 BlockModelCache、VariantModelCache、MultipartModelCache 的优先级)
+// 缓存在导出期间只增不删,指针在整个导出过程中有效
+struct BlockModelRefs {
+    const ModelData* model = nullptr;
+    const std::vector<WeightedModelData>* variants = nullptr;
+    int totalWeight = 0;
+    MultipartCombinations* multipart = nullptr;
+};
+
+BlockModelRefs GetBlockModelRefs(const std::string& namespaceName, const std::string& blockId);
+
+// 按全局方块ID查询模型候选:首次查询后发布到 BlockTraits::model,之后只读取该句柄
+const BlockModelRefs& GetBlockModelRefs(int blockId);
+
+// 按 GetRandomModelFromCache 的规则选择模型,不复制模型数据,没有模型时返回 nullptr
+const ModelData* PickRandomModel(const BlockModelRefs& refs);
+
 ModelData GetRandomModelFromCache(const std::string& namespaceName, const std::string& blockId);
 
 
@@ -7,24 +7,28 @@
  * 区域文件(Region File)通常包含32x32个区块的数据，以mca格式存储。
  */
 #pragma once
+#include <span>
 #include <vector>
 
 /**
- * @brief 从区域文件数据中读取特定区块的NBT数据
+ * @brief 读取特定区块的NBT数据
+ * 
+ * 通过区域文件头索引定位区块，只读取该区块占用的扇区;
+ * 导出需要区域中大部分区块时直接使用整文件映射。
  * 
- * @param fileData 区域文件的完整二进制数据
  * @param x 区块的X坐标(全局坐标)
  * @param z 区块的Z坐标(全局坐标)
- * @return std::vector<char> 解压后的区块NBT数据，如果提取失败则返回空vector
+ * @param chunkData 输出:解压后的区块NBT数据，复用其已有容量以避免每个区块重新分配
+ * @return bool 成功返回true，区块不存在或读取失败返回false
  */
-std::vector<char> GetChunkNBTData(const std::vector<char>& fileData, int x, int z);
+bool GetChunkNBTData(int x, int z, std::vector<char>& chunkData);
 
 /**
  * @brief 解析区块的高度图数据
  * 
  * 高度图数据表示区块中每个列(x,z位置)的最高非空气方块的y坐标
  * 
- * @param data 从NBT数据中提取的原始高度图数据(通常是一组Long值)
+ * @param packed 高度图 LONG_ARRAY 的原始(大端)字节
  * @return std::vector<int> 由256个高度值组成的数组，对应区块内16x16个列
  */
-std::vector<int> DecodeHeightMap(const std::vector<int64_t>& data);
\ No newline at end of file
+std::vector<int> DecodeHeightMap(std::span<const char> packed);
\ No newline at end of file
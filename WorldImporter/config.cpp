@@ -80,6 +80,9 @@ Config LoadConfig(const std::string& configFile) {
     
     // 读取每批次的区块任务数量上限（如果存在）
     config.maxTasksPerBatch = j.value("maxTasksPerBatch", config.maxTasksPerBatch);
+    config.regionCacheBudgetMB = j.value("regionCacheBudgetMB", config.regionCacheBudgetMB);
+    config.useReadaheadHint = j.value("useReadaheadHint", config.useReadaheadHint);
+    config.loaderThreads = j.value("loaderThreads", config.loaderThreads);
 
 
     config.selectedDimension = j.value("selectedDimension", config.selectedDimension);
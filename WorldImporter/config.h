@@ -64,6 +64,9 @@ struct Config {
     bool exportFullModel;  // 是否完整导入
     int partitionSize; //分割大小
     size_t maxTasksPerBatch; //每批次区块任务数量上限
+    size_t regionCacheBudgetMB; //region 文件映射缓存上限(MB)
+    bool useReadaheadHint; //按扇区顺序加载时向系统发送预读提示
+    int loaderThreads; //区块加载线程数,0 为 CPU 核心数
 
     int decimalPlaces; //lod群系颜色值小数精度 #待做
     bool importByBlockType;  // 是否按方块种类导入 #待做
@@ -110,6 +113,9 @@ struct Config {
         exportFullModel(false),
         partitionSize(4),
         maxTasksPerBatch(32768),
+        regionCacheBudgetMB(1024),
+        useReadaheadHint(true),
+        loaderThreads(0),
 
         decimalPlaces(2),
         importByBlockType(false),
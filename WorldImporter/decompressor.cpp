@@ -1,35 +1,254 @@
 ﻿#include <zlib.h>
 #include <iostream>
+#include <cstring>
+#include <algorithm>
 #include "decompressor.h"
+#ifdef WORLDIMPORTER_USE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
 
-// 解压区块数据
-bool DecompressData(const std::vector<char>& chunkData, std::vector<char>& decompressedData) {
-    // 输出压缩数据的大小
-    uLongf decompressedSize = chunkData.size() * 10;  // 假设解压后的数据大小为压缩数据的 10 倍
-    decompressedData.resize(decompressedSize);
+// 输出缓冲区的初始容量估计(压缩数据大小的倍数)
+static constexpr size_t kInitialRatio = 8;
 
-    // 调用解压函数
-    int result = uncompress(reinterpret_cast<Bytef*>(decompressedData.data()), &decompressedSize,
-        reinterpret_cast<const Bytef*>(chunkData.data()), chunkData.size());
+// 输出缓冲区的最小容量:压缩数据为空时按倍数估计为 0,必须保证有空间可写
+static constexpr size_t kMinOutputSize = 64 * 1024;
 
-    // 如果输出缓冲区太小,则动态扩展缓冲区
-    while (result == Z_BUF_ERROR) {
-        decompressedSize *= 2;  // 增加缓冲区大小
-        decompressedData.resize(decompressedSize);
-        result = uncompress(reinterpret_cast<Bytef*>(decompressedData.data()), &decompressedSize,
-            reinterpret_cast<const Bytef*>(chunkData.data()), chunkData.size());
+// 确保输出缓冲区至少有 size 字节(不少于 kMinOutputSize)可写,按需翻倍增长并保留已解压内容
+static void GrowOutput(std::vector<char>& output, size_t size) {
+    size = std::max(size, kMinOutputSize);
+    if (output.size() < size) {
+        output.resize(std::max(size, output.size() * 2));
+    }
+}
 
+#ifdef WORLDIMPORTER_USE_LIBDEFLATE
+// libdeflate 后端:每个线程复用一个解压器
+static bool InflateLibdeflate(bool gzip, std::span<const char> input, std::vector<char>& output) {
+    thread_local struct DecompressorHolder {
+        libdeflate_decompressor* d = libdeflate_alloc_decompressor();
+        ~DecompressorHolder() { libdeflate_free_decompressor(d); }
+    } holder;
+    if (!holder.d) {
+        std::cerr << "错误: 创建解压器失败" << std::endl;
+        return false;
     }
 
-    // 根据解压结果提供不同的日志信息
-    if (result == Z_OK) {
-        decompressedData.resize(decompressedSize);  // 修正解压数据的实际大小
-        return true;
+    GrowOutput(output, input.size() * kInitialRatio);
+    while (true) {
+        size_t actual = 0;
+        libdeflate_result result = gzip
+            ? libdeflate_gzip_decompress(holder.d, input.data(), input.size(), output.data(), output.size(), &actual)
+            : libdeflate_zlib_decompress(holder.d, input.data(), input.size(), output.data(), output.size(), &actual);
+        if (result == LIBDEFLATE_SUCCESS) {
+            output.resize(actual);
+            return true;
+        }
+        if (result != LIBDEFLATE_INSUFFICIENT_SPACE) {
+            std::cerr << "错误: 解压失败,错误代码: " << result << std::endl;
+            return false;
+        }
+        // libdeflate 需要完整输出缓冲区,空间不足时扩容后重试
+        GrowOutput(output, output.size() * 2);
     }
-    else {
-        std::cerr <<"错误: 解压失败,错误代码: " << result << std::endl;
+}
+#else
+// zlib 后端:每个线程复用一个 inflate 状态,流式解压,输出不足时就地扩容继续,不重新解压
+static bool InflateZlib(std::span<const char> input, std::vector<char>& output) {
+    thread_local struct InflateState {
+        z_stream strm{};
+        bool ready = false;
+        ~InflateState() { if (ready) inflateEnd(&strm); }
+    } state;
 
-        return false;
+    z_stream& strm = state.strm;
+    if (!state.ready) {
+        // windowBits 15 + 32: 自动识别 zlib 与 gzip 头
+        if (inflateInit2(&strm, 15 + 32) != Z_OK) {
+            std::cerr << "错误: 初始化解压器失败" << std::endl;
+            return false;
+        }
+        state.ready = true;
+    } else {
+        inflateReset(&strm);
     }
+
+    GrowOutput(output, input.size() * kInitialRatio);
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    strm.avail_in = static_cast<uInt>(input.size());
+
+    size_t produced = 0;
+    int result = Z_OK;
+    while (true) {
+        if (produced == output.size()) {
+            GrowOutput(output, output.size() * 2);
+        }
+        strm.next_out = reinterpret_cast<Bytef*>(output.data() + produced);
+        strm.avail_out = static_cast<uInt>(output.size() - produced);
+        const uInt availIn = strm.avail_in;
+        const size_t producedBefore = produced;
+        result = inflate(&strm, Z_NO_FLUSH);
+        produced = output.size() - strm.avail_out;
+        if (result == Z_STREAM_END) {
+            break;
+        }
+        // 输出空间充足时既未消耗输入也未产生输出,继续调用不会有进展(例如数据为空)
+        if (strm.avail_in == availIn && produced == producedBefore) {
+            std::cerr << "错误: 解压失败,数据不完整" << std::endl;
+            return false;
+        }
+        // 输入耗尽仍未结束,或出现其他错误
+        if (result != Z_OK && !(result == Z_BUF_ERROR && strm.avail_out == 0)) {
+            std::cerr << "错误: 解压失败,错误代码: " << result << std::endl;
+            return false;
+        }
+        if (strm.avail_in == 0 && strm.avail_out != 0) {
+            std::cerr << "错误: 解压失败,数据不完整" << std::endl;
+            return false;
+        }
+    }
+    output.resize(produced);
+    return true;
 }
+#endif
+
+// 解压单个 LZ4 块(原始块格式,无帧头),返回解压后字节数,失败返回 -1
+static long long DecompressLZ4Block(const uint8_t* src, size_t srcSize, char* dst, size_t dstSize) {
+    const uint8_t* ip = src;
+    const uint8_t* const iend = src + srcSize;
+    char* op = dst;
+    char* const oend = dst + dstSize;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        // 字面量长度
+        size_t literalLength = token >> 4;
+        if (literalLength == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) return -1;
+                b = *ip++;
+                literalLength += b;
+            } while (b == 255);
+        }
+        if (literalLength > static_cast<size_t>(iend - ip) || literalLength > static_cast<size_t>(oend - op)) return -1;
+        std::memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
 
+        // 最后一个序列只有字面量
+        if (ip >= iend) break;
+
+        // 匹配偏移与长度
+        if (iend - ip < 2) return -1;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst)) return -1;
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) return -1;
+                b = *ip++;
+                matchLength += b;
+            } while (b == 255);
+        }
+        matchLength += 4;
+        if (matchLength > static_cast<size_t>(oend - op)) return -1;
+
+        // 匹配区可能与输出重叠,逐字节复制
+        const char* match = op - offset;
+        if (offset >= matchLength) {
+            std::memcpy(op, match, matchLength);
+            op += matchLength;
+        } else {
+            for (size_t i = 0; i < matchLength; ++i) {
+                *op++ = *match++;
+            }
+        }
+    }
+    return op - dst;
+}
+
+static uint32_t ReadLE32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+        (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// 解压 LZ4 数据(lz4-java 的 LZ4BlockOutputStream 格式)
+// 每块头部 21 字节: "LZ4Block" + 类型字节 + 压缩长度 + 原始长度 + 校验和(均为小端)
+static bool InflateLZ4(std::span<const char> input, std::vector<char>& output) {
+    static const char kMagic[8] = { 'L', 'Z', '4', 'B', 'l', 'o', 'c', 'k' };
+    constexpr size_t kHeaderSize = 21;
+    constexpr uint8_t kMethodRaw = 0x10;
+    constexpr uint8_t kMethodLZ4 = 0x20;
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(input.data());
+    size_t remaining = input.size();
+    size_t produced = 0;
+
+    while (remaining >= kHeaderSize) {
+        if (std::memcmp(p, kMagic, sizeof(kMagic)) != 0) {
+            std::cerr << "错误: LZ4 数据头无效" << std::endl;
+            return false;
+        }
+        uint8_t method = p[8] & 0xF0;
+        uint32_t compressedLength = ReadLE32(p + 9);
+        uint32_t originalLength = ReadLE32(p + 13);
+        p += kHeaderSize;
+        remaining -= kHeaderSize;
+
+        // 长度为 0 的块表示流结束
+        if (originalLength == 0) {
+            break;
+        }
+        if (compressedLength > remaining) {
+            std::cerr << "错误: LZ4 数据不完整" << std::endl;
+            return false;
+        }
+
+        GrowOutput(output, produced + originalLength);
+        if (method == kMethodRaw) {
+            if (compressedLength != originalLength) return false;
+            std::memcpy(output.data() + produced, p, originalLength);
+        } else if (method == kMethodLZ4) {
+            long long n = DecompressLZ4Block(p, compressedLength, output.data() + produced, originalLength);
+            if (n != static_cast<long long>(originalLength)) {
+                std::cerr << "错误: LZ4 解压失败" << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "错误: 未知的 LZ4 块类型: " << static_cast<int>(method) << std::endl;
+            return false;
+        }
+        produced += originalLength;
+        p += compressedLength;
+        remaining -= compressedLength;
+    }
+    output.resize(produced);
+    return true;
+}
+
+// 解压区块数据
+bool DecompressData(uint8_t compressionType, std::span<const char> chunkData, std::vector<char>& decompressedData) {
+    switch (static_cast<ChunkCompression>(compressionType)) {
+    case ChunkCompression::GZip:
+    case ChunkCompression::Zlib:
+#ifdef WORLDIMPORTER_USE_LIBDEFLATE
+        return InflateLibdeflate(compressionType == static_cast<uint8_t>(ChunkCompression::GZip), chunkData, decompressedData);
+#else
+        return InflateZlib(chunkData, decompressedData);
+#endif
+    case ChunkCompression::None:
+        decompressedData.assign(chunkData.begin(), chunkData.end());
+        return true;
+    case ChunkCompression::LZ4:
+        decompressedData.clear();
+        return InflateLZ4(chunkData, decompressedData);
+    default:
+        // 高位为 1 表示区块数据存放在外部 .mcc 文件中,暂不支持
+        std::cerr << "错误: 不支持的压缩类型: " << static_cast<int>(compressionType) << std::endl;
+        return false;
+    }
+}
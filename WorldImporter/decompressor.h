@@ -3,8 +3,20 @@
 
 #include <vector>
 #include <string> 
+#include <span>
+#include <cstdint>
 
-//zlib解压方法
-bool DecompressData(const std::vector<char>& chunkData, std::vector<char>& decompressedData);
+// region 文件中的区块压缩类型
+enum class ChunkCompression : uint8_t {
+    GZip = 1,
+    Zlib = 2,
+    None = 3,
+    LZ4 = 4
+};
+
+// 解压区块数据
+// compressionType 为区块载荷中的压缩类型字节,chunkData 直接引用 region 数据(不复制)
+// 输出写入 decompressedData,复用其已有容量;定义 WORLDIMPORTER_USE_LIBDEFLATE 时 gzip/zlib 使用 libdeflate 解压
+bool DecompressData(uint8_t compressionType, std::span<const char> chunkData, std::vector<char>& decompressedData);
 
 #endif // DECOMPRESSOR_H
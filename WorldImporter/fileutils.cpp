@@ -145,11 +145,9 @@ void RegisterFluidTextures() {
         std::string textureSavePath1 = "textures/" + ns + "/" + pathPart1 + ".png";
         std::string textureSavePath2 = "textures/" + ns + "/" + pathPart2 + ".png";
         // 注册材质(带命名空间)
-        std::string Dir = "textures";
-        std::string Dir2 = "textures";
-        SaveTextureToFile(ns, pathPart1, Dir);
+        SaveTextureOnce(ns, pathPart1);
         RegisterTexture(ns, pathPart1, textureSavePath1);
-        SaveTextureToFile(ns, pathPart2, Dir2);
+        SaveTextureOnce(ns, pathPart2);
         RegisterTexture(ns, pathPart2, textureSavePath2);
     }
 }
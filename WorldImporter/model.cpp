@@ -361,8 +361,9 @@ void ApplyRotationToUV(ModelData& modelData, int rotationX, int rotationY) {
         else {
             // 未处理的旋转组合
             static std::unordered_set<std::string> warnedCases;
-            if (warnedCases.find(caseKey) == warnedCases.end()) {
-                warnedCases.insert(caseKey);
+            static std::mutex warnedCasesMutex; // 方块状态可在多个线程中并行烘焙
+            std::lock_guard<std::mutex> lock(warnedCasesMutex);
+            if (warnedCases.insert(caseKey).second) {
                 std::cerr << "Bad UV lock rotation in model: " << caseKey << std::endl;
             }
         }
@@ -682,13 +683,12 @@ void processTextures(const nlohmann::json& modelJson, ModelData& data,
                     if (cacheIt != texturePathCache.end()) {
                         textureSavePath = cacheIt->second;
                     }
-                    else {
-                        std::string saveDir = "textures";
-                        SaveTextureToFile(namespaceName, pathPart, saveDir);
-                        textureSavePath = "textures/" + namespaceName+"/"+pathPart + ".png";
-                        // 调用注册材质的方法
-                        RegisterTexture(namespaceName, pathPart, textureSavePath);
-                    }
+                }
+                if (textureSavePath.empty()) {
+                    SaveTextureOnce(namespaceName, pathPart);
+                    textureSavePath = "textures/" + namespaceName+"/"+pathPart + ".png";
+                    // 调用注册材质的方法
+                    RegisterTexture(namespaceName, pathPart, textureSavePath);
                 }
 
                 // 记录材质信息
@@ -1248,49 +1248,43 @@ ModelData ProcessModelJson(const std::string& namespaceName, const std::string&
     // 生成唯一缓存键(添加模型索引)
     std::string cacheKey = namespaceName + ":" + blockId + ":" + std::to_string(randomIndex);
 
-    // 在访问缓存前加锁
-    std::lock_guard<std::mutex> lock(cacheMutex);
-    // 检查缓存是否存在(同时查扩展key,SpecialBlock方块如床)
-    auto cacheIt = modelCache.find(cacheKey);
-    if (cacheIt == modelCache.end() && !blockstateName.empty()) {
-        cacheIt = modelCache.find(cacheKey + "@" + blockstateName);
-    }
-    if (cacheIt != modelCache.end()) {
-        // 从缓存中获取原始模型数据
-        ModelData cachedModel = cacheIt->second;
-        if (rotationX != 0 || rotationY != 0) {
-            // 使用C++20的span进行函数调用
-            ApplyRotationToVertices(std::span<float>(cachedModel.vertices.data(), cachedModel.vertices.size()), rotationX, rotationY);
-        }
-        if (uvlock)
-        {
-            ApplyRotationToUV(cachedModel, rotationX, rotationY);
-        }
-        // 施加旋转到 faceDirections
-        ApplyRotationToFaceDirections(cachedModel.faces, rotationX, rotationY);
-        return cachedModel;
-    }
-    // 缓存未命中,正常加载模型
-    nlohmann::json modelJson = GetModelJson(namespaceName, blockId);
-
+    // 只在访问缓存时加锁,模型解析与旋转在锁外进行,多个线程可以同时烘焙不同的方块状态
     ModelData modelData;
-    if (modelJson.is_null()) {
-        return modelData;
+    bool cached = false;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        // 检查缓存是否存在(同时查扩展key,SpecialBlock方块如床)
+        auto cacheIt = modelCache.find(cacheKey);
+        if (cacheIt == modelCache.end() && !blockstateName.empty()) {
+            cacheIt = modelCache.find(cacheKey + "@" + blockstateName);
+        }
+        if (cacheIt != modelCache.end()) {
+            // 从缓存中获取原始模型数据
+            modelData = cacheIt->second;
+            cached = true;
+        }
     }
-    // 递归加载父模型并合并属性
-    modelJson = LoadParentModel(namespaceName, blockId, modelJson);
-    
-    // 处理模型数据(不包含旋转)
-    modelData = ProcessModelData(modelJson,blockstateName);
-
-
-    // 将原始数据存入缓存(不包含旋转)
-    // SpecialBlock 方块(床等)用 blockstateName 区分缓存，避免不同颜色共用
-    std::string storeKey = cacheKey;
-    if (!modelJson.contains("elements") && !blockstateName.empty()) {
-        storeKey = cacheKey + "@" + blockstateName;
+    if (!cached) {
+        // 缓存未命中,正常加载模型
+        nlohmann::json modelJson = GetModelJson(namespaceName, blockId);
+        if (modelJson.is_null()) {
+            return modelData;
+        }
+        // 递归加载父模型并合并属性
+        modelJson = LoadParentModel(namespaceName, blockId, modelJson);
+
+        // 处理模型数据(不包含旋转)
+        modelData = ProcessModelData(modelJson,blockstateName);
+
+        // 将原始数据存入缓存(不包含旋转),并发解析同一模型时保留先写入的结果
+        // SpecialBlock 方块(床等)用 blockstateName 区分缓存，避免不同颜色共用
+        std::string storeKey = cacheKey;
+        if (!modelJson.contains("elements") && !blockstateName.empty()) {
+            storeKey = cacheKey + "@" + blockstateName;
+        }
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        modelCache.try_emplace(std::move(storeKey), modelData);
     }
-    modelCache[storeKey] = modelData;
 
     if (rotationX != 0 || rotationY != 0) {
         // 如果指定了旋转,则应用旋转
@@ -0,0 +1,460 @@
+#include "nbtview.h"
+#include "bitutils.h"
+#include <cmath>
+#include <stdexcept>
+
+// 读取大端序整数
+template <typename T>
+static T ReadBigEndian(const char* p) {
+    using U = std::make_unsigned_t<T>;
+    U value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        value = static_cast<U>((value << 8) | static_cast<uint8_t>(p[i]));
+    }
+    return static_cast<T>(value);
+}
+
+// --------------------------------------------------------------------------------
+// NbtSchema
+// --------------------------------------------------------------------------------
+NbtSchema& NbtSchema::Keep(std::string_view path) {
+    NbtSchema* node = this;
+    while (!path.empty()) {
+        size_t slash = path.find('/');
+        std::string_view name = path.substr(0, slash);
+        path = (slash == std::string_view::npos) ? std::string_view() : path.substr(slash + 1);
+
+        NbtSchema* next = nullptr;
+        for (auto& child : node->children) {
+            if (child.first == name) {
+                next = child.second.get();
+                break;
+            }
+        }
+        if (!next) {
+            node->children.emplace_back(std::string(name), std::make_unique<NbtSchema>());
+            next = node->children.back().second.get();
+        }
+        node = next;
+    }
+    node->keepAll = true;
+    return *this;
+}
+
+const NbtSchema* NbtSchema::Find(std::string_view name) const {
+    for (const auto& child : children) {
+        if (child.first == name) {
+            return child.second.get();
+        }
+    }
+    return nullptr;
+}
+
+// --------------------------------------------------------------------------------
+// NbtDocument 解析
+// --------------------------------------------------------------------------------
+void NbtDocument::Parse(std::span<const char> buffer, const NbtSchema* schema) {
+    data = buffer;
+    nodes.clear();
+    size_t index = 0;
+    if (schema && schema->KeepsAll()) {
+        schema = nullptr;
+    }
+    if (ReadNamedTag(index, schema) == NbtNode::kNone) {
+        throw std::runtime_error("Root tag is TAG_End");
+    }
+}
+
+uint32_t NbtDocument::ReadLength(size_t& index) {
+    if (index + 4 > data.size()) throw std::out_of_range("Not enough data to read length");
+    int32_t length = ReadBigEndian<int32_t>(data.data() + index);
+    index += 4;
+    if (length < 0) throw std::runtime_error("Negative NBT length");
+    return static_cast<uint32_t>(length);
+}
+
+// 读取带名称的根标签,遇到 TAG_End 返回 kNone
+uint32_t NbtDocument::ReadNamedTag(size_t& index, const NbtSchema* schema) {
+    if (index >= data.size()) {
+        throw std::out_of_range("Index out of bounds while reading tag type");
+    }
+    TagType type = static_cast<TagType>(static_cast<uint8_t>(data[index]));
+    index++;
+    if (type == TagType::END) {
+        return NbtNode::kNone;
+    }
+
+    if (index + 2 > data.size()) throw std::out_of_range("Not enough data to read tag name length");
+    uint16_t nameLength = ReadBigEndian<uint16_t>(data.data() + index);
+    index += 2;
+    if (index + nameLength > data.size()) throw std::out_of_range("Not enough data to read tag name");
+
+    uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+    NbtNode& node = nodes.emplace_back();
+    node.type = type;
+    node.listType = TagType::END;
+    node.nameLength = nameLength;
+    node.nameOffset = static_cast<uint32_t>(index);
+    index += nameLength;
+
+    ReadPayload(nodeIndex, index, schema);
+    return nodeIndex;
+}
+
+// 按长度跳过一个标签载荷,不生成节点
+// 只有 LIST/COMPOUND 需要逐个遍历,标量、字符串和数组直接跳过
+void NbtDocument::SkipPayload(TagType type, size_t& index) {
+    switch (type) {
+    case TagType::BYTE: index += 1; break;
+    case TagType::SHORT: index += 2; break;
+    case TagType::INT:
+    case TagType::FLOAT: index += 4; break;
+    case TagType::LONG:
+    case TagType::DOUBLE: index += 8; break;
+    case TagType::STRING: {
+        if (index + 2 > data.size()) throw std::out_of_range("Not enough data to read string length");
+        index += 2 + ReadBigEndian<uint16_t>(data.data() + index);
+        break;
+    }
+    case TagType::BYTE_ARRAY: index += static_cast<size_t>(ReadLength(index)); break;
+    case TagType::INT_ARRAY: index += static_cast<size_t>(ReadLength(index)) * 4; break;
+    case TagType::LONG_ARRAY: index += static_cast<size_t>(ReadLength(index)) * 8; break;
+    case TagType::LIST: {
+        if (index >= data.size()) throw std::out_of_range("Index out of bounds while reading TAG_List element type");
+        TagType listType = static_cast<TagType>(static_cast<uint8_t>(data[index++]));
+        uint32_t length = ReadLength(index);
+        size_t fixedSize = 0;
+        switch (listType) {
+        case TagType::END: fixedSize = 0; length = 0; break;
+        case TagType::BYTE: fixedSize = 1; break;
+        case TagType::SHORT: fixedSize = 2; break;
+        case TagType::INT:
+        case TagType::FLOAT: fixedSize = 4; break;
+        case TagType::LONG:
+        case TagType::DOUBLE: fixedSize = 8; break;
+        default: break;
+        }
+        if (fixedSize > 0) {
+            index += fixedSize * length;
+        } else {
+            for (uint32_t i = 0; i < length; ++i) {
+                SkipPayload(listType, index);
+            }
+        }
+        break;
+    }
+    case TagType::COMPOUND: {
+        while (true) {
+            if (index >= data.size()) throw std::out_of_range("Index out of bounds while reading tag type");
+            TagType childType = static_cast<TagType>(static_cast<uint8_t>(data[index++]));
+            if (childType == TagType::END) break;
+            if (index + 2 > data.size()) throw std::out_of_range("Not enough data to read tag name length");
+            index += 2 + ReadBigEndian<uint16_t>(data.data() + index);
+            SkipPayload(childType, index);
+        }
+        break;
+    }
+    default:
+        throw std::runtime_error("Unsupported tag type: " + std::to_string(static_cast<int>(type)));
+    }
+    if (index > data.size()) throw std::out_of_range("Not enough data for skipped tag");
+}
+
+// 读取节点载荷;节点数组在递归中可能扩容,因此只通过下标访问节点
+// schema 为空表示保留整个子树
+void NbtDocument::ReadPayload(uint32_t nodeIndex, size_t& index, const NbtSchema* schema) {
+    TagType type = nodes[nodeIndex].type;
+    size_t scalarSize = 0;
+    switch (type) {
+    case TagType::BYTE: scalarSize = 1; break;
+    case TagType::SHORT: scalarSize = 2; break;
+    case TagType::INT:
+    case TagType::FLOAT: scalarSize = 4; break;
+    case TagType::LONG:
+    case TagType::DOUBLE: scalarSize = 8; break;
+    default: break;
+    }
+    if (scalarSize > 0) {
+        if (index + scalarSize > data.size()) throw std::out_of_range("Not enough data for scalar tag");
+        nodes[nodeIndex].payloadOffset = static_cast<uint32_t>(index);
+        nodes[nodeIndex].payloadLength = static_cast<uint32_t>(scalarSize);
+        index += scalarSize;
+        return;
+    }
+
+    switch (type) {
+    case TagType::STRING: {
+        if (index + 2 > data.size()) throw std::out_of_range("Not enough data to read string length");
+        uint16_t length = ReadBigEndian<uint16_t>(data.data() + index);
+        index += 2;
+        if (index + length > data.size()) throw std::out_of_range("Not enough data to read string content");
+        nodes[nodeIndex].payloadOffset = static_cast<uint32_t>(index);
+        nodes[nodeIndex].payloadLength = length;
+        index += length;
+        break;
+    }
+    case TagType::BYTE_ARRAY:
+    case TagType::INT_ARRAY:
+    case TagType::LONG_ARRAY: {
+        size_t elementSize = (type == TagType::BYTE_ARRAY) ? 1 : (type == TagType::INT_ARRAY) ? 4 : 8;
+        uint64_t byteLength = static_cast<uint64_t>(ReadLength(index)) * elementSize;
+        if (index + byteLength > data.size()) throw std::out_of_range("Not enough data for array payload");
+        nodes[nodeIndex].payloadOffset = static_cast<uint32_t>(index);
+        nodes[nodeIndex].payloadLength = static_cast<uint32_t>(byteLength);
+        index += static_cast<size_t>(byteLength);
+        break;
+    }
+    case TagType::LIST: {
+        if (index >= data.size()) throw std::out_of_range("Index out of bounds while reading TAG_List element type");
+        TagType listType = static_cast<TagType>(static_cast<uint8_t>(data[index++]));
+        uint32_t length = ReadLength(index);
+        nodes[nodeIndex].listType = listType;
+        nodes[nodeIndex].payloadOffset = static_cast<uint32_t>(index);
+        nodes[nodeIndex].payloadLength = (listType == TagType::END) ? 0 : length;
+        if (listType == TagType::END) {
+            break;
+        }
+        uint32_t prev = NbtNode::kNone;
+        for (uint32_t i = 0; i < length; ++i) {
+            uint32_t elem = static_cast<uint32_t>(nodes.size());
+            NbtNode& node = nodes.emplace_back();
+            node.type = listType;
+            node.listType = TagType::END;
+            node.nameLength = 0;
+            node.nameOffset = 0;
+            if (prev == NbtNode::kNone) nodes[nodeIndex].firstChild = elem;
+            else nodes[prev].nextSibling = elem;
+            ReadPayload(elem, index, schema); // 白名单路径直接作用于列表元素
+            prev = elem;
+        }
+        break;
+    }
+    case TagType::COMPOUND: {
+        nodes[nodeIndex].payloadOffset = static_cast<uint32_t>(index);
+        uint32_t count = 0;
+        uint32_t prev = NbtNode::kNone;
+        while (true) {
+            if (index >= data.size()) throw std::out_of_range("Index out of bounds while reading tag type");
+            TagType childType = static_cast<TagType>(static_cast<uint8_t>(data[index]));
+            if (childType == TagType::END) {
+                index++;
+                break; // 遇到TAG_End
+            }
+            const NbtSchema* childSchema = nullptr;
+            if (schema) {
+                // 不在白名单中的子标签按长度跳过
+                if (index + 3 > data.size()) throw std::out_of_range("Not enough data to read tag name length");
+                uint16_t nameLength = ReadBigEndian<uint16_t>(data.data() + index + 1);
+                if (index + 3 + nameLength > data.size()) throw std::out_of_range("Not enough data to read tag name");
+                childSchema = schema->Find(std::string_view(data.data() + index + 3, nameLength));
+                if (!childSchema) {
+                    index += 3 + nameLength;
+                    SkipPayload(childType, index);
+                    continue;
+                }
+                if (childSchema->KeepsAll()) {
+                    childSchema = nullptr;
+                }
+            }
+            uint32_t child = ReadNamedTag(index, childSchema);
+            if (prev == NbtNode::kNone) nodes[nodeIndex].firstChild = child;
+            else nodes[prev].nextSibling = child;
+            prev = child;
+            ++count;
+        }
+        nodes[nodeIndex].payloadLength = count;
+        nodes[nodeIndex].payloadEnd = static_cast<uint32_t>(index);
+        break;
+    }
+    default:
+        throw std::runtime_error("Unsupported tag type: " + std::to_string(static_cast<int>(type)));
+    }
+}
+
+// --------------------------------------------------------------------------------
+// NbtRef 访问
+// --------------------------------------------------------------------------------
+const NbtNode& NbtRef::Node() const {
+    return doc->NodeAt(index);
+}
+
+TagType NbtRef::Type() const {
+    return Node().type;
+}
+
+TagType NbtRef::ListType() const {
+    return Node().listType;
+}
+
+std::string_view NbtRef::Name() const {
+    const NbtNode& node = Node();
+    return std::string_view(doc->Data() + node.nameOffset, node.nameLength);
+}
+
+NbtRef NbtRef::Child(std::string_view name) const {
+    if (!*this || Node().type != TagType::COMPOUND) {
+        return NbtRef();
+    }
+    for (NbtRef child : *this) {
+        if (child.Name() == name) {
+            return child;
+        }
+    }
+    return NbtRef();
+}
+
+size_t NbtRef::Size() const {
+    const NbtNode& node = Node();
+    return (node.type == TagType::LIST || node.type == TagType::COMPOUND) ? node.payloadLength : 0;
+}
+
+int8_t NbtRef::AsByte() const {
+    return static_cast<int8_t>(doc->Data()[Node().payloadOffset]);
+}
+
+int16_t NbtRef::AsShort() const {
+    return ReadBigEndian<int16_t>(doc->Data() + Node().payloadOffset);
+}
+
+int32_t NbtRef::AsInt() const {
+    return ReadBigEndian<int32_t>(doc->Data() + Node().payloadOffset);
+}
+
+int64_t NbtRef::AsLong() const {
+    return ReadBigEndian<int64_t>(doc->Data() + Node().payloadOffset);
+}
+
+float NbtRef::AsFloat() const {
+    uint32_t bits = ReadBigEndian<uint32_t>(doc->Data() + Node().payloadOffset);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+double NbtRef::AsDouble() const {
+    uint64_t bits = ReadBigEndian<uint64_t>(doc->Data() + Node().payloadOffset);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::string_view NbtRef::AsString() const {
+    const NbtNode& node = Node();
+    if (node.type != TagType::STRING) return {};
+    return std::string_view(doc->Data() + node.payloadOffset, node.payloadLength);
+}
+
+std::span<const char> NbtRef::Bytes() const {
+    const NbtNode& node = Node();
+    if (node.type == TagType::LIST || node.type == TagType::COMPOUND) return {};
+    return std::span<const char>(doc->Data() + node.payloadOffset, node.payloadLength);
+}
+
+std::span<const char> NbtRef::RawCompound() const {
+    const NbtNode& node = Node();
+    if (node.type != TagType::COMPOUND) return {};
+    return std::span<const char>(doc->Data() + node.payloadOffset, node.payloadEnd - node.payloadOffset);
+}
+
+int32_t NbtRef::IntAt(size_t i) const {
+    return ReadBigEndian<int32_t>(doc->Data() + Node().payloadOffset + i * 4);
+}
+
+int64_t NbtRef::LongAt(size_t i) const {
+    return ReadBigEndian<int64_t>(doc->Data() + Node().payloadOffset + i * 8);
+}
+
+size_t NbtRef::ArrayLength() const {
+    const NbtNode& node = Node();
+    switch (node.type) {
+    case TagType::BYTE_ARRAY: return node.payloadLength;
+    case TagType::INT_ARRAY: return node.payloadLength / 4;
+    case TagType::LONG_ARRAY: return node.payloadLength / 8;
+    default: return 0;
+    }
+}
+
+NbtRef::Iterator& NbtRef::Iterator::operator++() {
+    index = doc->NodeAt(index).nextSibling;
+    return *this;
+}
+
+NbtRef::Iterator NbtRef::begin() const {
+    if (!*this) return end();
+    return Iterator(doc, Node().firstChild);
+}
+
+// --------------------------------------------------------------------------------
+// 实用方法(与 nbtutils 中基于 NbtTag 的版本行为一致)
+// --------------------------------------------------------------------------------
+std::vector<std::string> getBlockPalette(NbtRef blockStatesTag) {
+    std::vector<std::string> blockPalette;
+
+    NbtRef paletteTag = blockStatesTag.Child("palette");
+    if (!paletteTag || paletteTag.Type() != TagType::LIST) {
+        return blockPalette;
+    }
+    blockPalette.reserve(paletteTag.Size());
+    for (NbtRef blockTag : paletteTag) {
+        if (blockTag.Type() != TagType::COMPOUND) continue;
+
+        std::string blockName;
+        NbtRef nameTag = blockTag.Child("Name");
+        if (nameTag && nameTag.Type() == TagType::STRING) {
+            blockName = nameTag.AsString();
+        }
+
+        // 检查是否有 Properties,拼接后缀
+        NbtRef propertiesTag = blockTag.Child("Properties");
+        if (propertiesTag && propertiesTag.Type() == TagType::COMPOUND) {
+            bool first = true;
+            for (NbtRef property : propertiesTag) {
+                if (property.Type() != TagType::STRING) continue;
+                blockName += first ? '[' : ',';
+                blockName += property.Name();
+                blockName += ':';
+                blockName += property.AsString();
+                first = false;
+            }
+            if (!first) {
+                blockName += ']';
+            }
+        }
+        blockPalette.push_back(std::move(blockName));
+    }
+    return blockPalette;
+}
+
+std::vector<int> getBlockStatesData(NbtRef blockStatesTag, size_t paletteSize) {
+    // 子区块包含16x16x16=4096个方块
+    const int totalBlocks = 4096;
+    std::vector<int> blockStatesData(totalBlocks, 0);
+
+    NbtRef dataTag = blockStatesTag.Child("data");
+    if (!dataTag || dataTag.Type() != TagType::LONG_ARRAY) {
+        return blockStatesData;
+    }
+
+    // 根据调色板中方块状态的数量决定每个状态占用的位数
+    int bitsPerState = (paletteSize <= 16) ? 4 : static_cast<int>(std::ceil(std::log2(paletteSize)));
+
+    // 按照子区块内的 YZX 编码顺序(索引i = 256*y + 16*z + x)直接从原始字节解包4096个方块状态
+    UnpackPackedLongs(dataTag.Bytes(), bitsPerState, blockStatesData.data(), totalBlocks);
+    return blockStatesData;
+}
+
+std::vector<std::string> getBiomePalette(NbtRef biomesTag) {
+    NbtRef paletteTag = biomesTag.Child("palette");
+    if (!paletteTag || paletteTag.Type() != TagType::LIST) {
+        throw std::runtime_error("No valid palette tag found in biomes.");
+    }
+
+    std::vector<std::string> palette;
+    palette.reserve(paletteTag.Size());
+    for (NbtRef child : paletteTag) {
+        if (child.Type() == TagType::STRING) {
+            palette.emplace_back(child.AsString());
+        }
+    }
+    return palette;
+}
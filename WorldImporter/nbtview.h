@@ -0,0 +1,137 @@
+#ifndef NBTVIEW_H
+#define NBTVIEW_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "nbtutils.h"
+
+// 只读 NBT 视图
+// 与 readTag 构建的 NbtTag 树不同,NbtDocument 只遍历一次字节流,把所有标签平铺存放在一个节点数组中,
+// 名称和载荷都以偏移量引用原始(解压后的)缓冲区,解析过程不为单个标签分配内存。
+// 视图的生命周期不能超过原始缓冲区;同一个 NbtDocument 可重复 Parse,节点数组的容量会被复用。
+
+class NbtDocument;
+
+// 解析白名单
+// 以路径描述需要保留的标签(如 "sections/block_states"),路径末端的整个子树都会保留;
+// 未列出的标签只按长度跳过,不生成节点。路径经过 LIST 时直接作用于其元素。
+class NbtSchema {
+public:
+    NbtSchema& Keep(std::string_view path);
+
+    // 查找子标签对应的规则,未列出时返回 nullptr
+    const NbtSchema* Find(std::string_view name) const;
+    bool KeepsAll() const { return keepAll; }
+
+private:
+    bool keepAll = false;
+    std::vector<std::pair<std::string, std::unique_ptr<NbtSchema>>> children;
+};
+
+// 平铺节点
+struct NbtNode {
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    TagType type;
+    TagType listType;        // LIST 元素类型
+    uint16_t nameLength;
+    uint32_t nameOffset;
+    uint32_t payloadOffset;  // 数据起始位置(字符串/数组不含长度前缀)
+    uint32_t payloadLength;  // 标量/字符串/数组为字节数,LIST/COMPOUND 为子节点数
+    uint32_t firstChild = kNone;
+    uint32_t nextSibling = kNone;
+    uint32_t payloadEnd = 0;  // COMPOUND 载荷结束位置(含 TAG_End)
+};
+
+// 节点引用(文档指针 + 节点下标),可按值传递
+class NbtRef {
+public:
+    NbtRef() = default;
+    NbtRef(const NbtDocument* doc, uint32_t index) : doc(doc), index(index) {}
+
+    explicit operator bool() const { return doc != nullptr && index != NbtNode::kNone; }
+
+    TagType Type() const;
+    TagType ListType() const;
+    std::string_view Name() const;
+
+    // COMPOUND:按名称查找子标签,不存在时返回空引用
+    NbtRef Child(std::string_view name) const;
+    // LIST/COMPOUND 的子节点数量
+    size_t Size() const;
+
+    // 标量值(大端序转换为主机序)
+    int8_t AsByte() const;
+    int16_t AsShort() const;
+    int32_t AsInt() const;
+    int64_t AsLong() const;
+    float AsFloat() const;
+    double AsDouble() const;
+    std::string_view AsString() const;
+
+    // 原始载荷字节(数组为大端序)
+    std::span<const char> Bytes() const;
+    // COMPOUND 的原始载荷字节(子标签序列及结尾的 TAG_End),可复制后延迟解析
+    std::span<const char> RawCompound() const;
+    // INT_ARRAY / LONG_ARRAY 的第 i 个元素(主机序)
+    int32_t IntAt(size_t i) const;
+    int64_t LongAt(size_t i) const;
+    // 数组元素个数
+    size_t ArrayLength() const;
+
+    // 子节点迭代
+    class Iterator {
+    public:
+        Iterator(const NbtDocument* doc, uint32_t index) : doc(doc), index(index) {}
+        NbtRef operator*() const { return NbtRef(doc, index); }
+        Iterator& operator++();
+        bool operator!=(const Iterator& other) const { return index != other.index; }
+    private:
+        const NbtDocument* doc;
+        uint32_t index;
+    };
+    Iterator begin() const;
+    Iterator end() const { return Iterator(doc, NbtNode::kNone); }
+
+private:
+    const NbtNode& Node() const;
+
+    const NbtDocument* doc = nullptr;
+    uint32_t index = NbtNode::kNone;
+};
+
+class NbtDocument {
+public:
+    // 解析以命名根标签开始的 NBT 数据,数据格式错误时抛出 std::out_of_range / std::runtime_error
+    // schema 不为空时只为白名单内的标签生成节点,其余子树按长度跳过
+    void Parse(std::span<const char> data, const NbtSchema* schema = nullptr);
+
+    NbtRef Root() const { return NbtRef(this, nodes.empty() ? NbtNode::kNone : 0); }
+    const NbtNode& NodeAt(uint32_t index) const { return nodes[index]; }
+    const char* Data() const { return data.data(); }
+
+private:
+    uint32_t ReadNamedTag(size_t& index, const NbtSchema* schema);
+    void ReadPayload(uint32_t nodeIndex, size_t& index, const NbtSchema* schema);
+    void SkipPayload(TagType type, size_t& index);
+    uint32_t ReadLength(size_t& index);
+
+    std::span<const char> data;
+    std::vector<NbtNode> nodes;
+};
+
+// 读取 block_states 的 palette 数据(格式与 getBlockPalette 相同:"name[key:value,...]")
+std::vector<std::string> getBlockPalette(NbtRef blockStatesTag);
+
+// 解析 block_states 的 data 数据
+std::vector<int> getBlockStatesData(NbtRef blockStatesTag, size_t paletteSize);
+
+// 获取 biomes 下的 palette 标签(LIST 包含字符串)
+std::vector<std::string> getBiomePalette(NbtRef biomesTag);
+
+#endif // NBTVIEW_H
@@ -7,6 +7,11 @@
 
 std::unordered_map<std::string, std::string> texturePathCache; // 定义材质路径缓存
 std::unordered_map<std::string, TextureDimension> textureDimensionCache; // 定义材质尺寸缓存
+std::mutex texturePathCacheMutex;
+std::mutex textureDimensionMutex;
+
+static std::mutex textureSaveMutex;
+static std::unordered_map<std::string, bool> savedTextures; // "namespace:pathPart" -> 是否存在
 
 // PNG文件头部解析，读取图像尺寸
 bool GetPNGDimensions(const std::vector<unsigned char>& pngData, int& width, int& height) {
@@ -254,6 +259,16 @@ bool SaveTextureToFile(const std::string& namespaceName, const std::string& bloc
     }
 }
 
+bool SaveTextureOnce(const std::string& namespaceName, const std::string& pathPart) {
+    std::lock_guard<std::mutex> lock(textureSaveMutex);
+    auto [it, inserted] = savedTextures.try_emplace(namespaceName + ":" + pathPart, false);
+    if (inserted) {
+        std::string saveDir = "textures";
+        it->second = SaveTextureToFile(namespaceName, pathPart, saveDir);
+    }
+    return it->second;
+}
+
 void RegisterTexture(const std::string& namespaceName, const std::string& pathPart, const std::string& savePath) {
     std::string cacheKey = namespaceName + ":" + pathPart;
 
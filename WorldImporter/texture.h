@@ -17,7 +17,7 @@ enum MaterialType {
 
 // 纹理缓存和互斥锁
 extern std::unordered_map<std::string, std::string> texturePathCache; 
-static std::mutex texturePathCacheMutex;
+extern std::mutex texturePathCacheMutex;
 
 // 新增：纹理尺寸缓存（保存图片的宽高比）
 struct TextureDimension {
@@ -29,13 +29,17 @@ struct TextureDimension {
     TextureDimension(int w, int h) : width(w), height(h), aspectRatio(h > 0 && w > 0 ? static_cast<float>(h) / w : 1.0f) {}
 };
 extern std::unordered_map<std::string, TextureDimension> textureDimensionCache;
-static std::mutex textureDimensionMutex;
+extern std::mutex textureDimensionMutex;
 
 // 材质注册方法
 void RegisterTexture(const std::string& namespaceName, const std::string& pathPart, const std::string& savePath);
 
 bool SaveTextureToFile(const std::string& namespaceName, const std::string& blockId, std::string& savePath);
 
+// 保存纹理到 textures 目录,每个纹理只写一次文件,返回纹理是否存在
+// 方块状态在多个线程中并行烘焙,同一纹理可能被同时请求,写文件在此串行化
+bool SaveTextureOnce(const std::string& namespaceName, const std::string& pathPart);
+
 // 从PNG数据中读取图像尺寸
 bool GetPNGDimensions(const std::vector<unsigned char>& pngData, int& width, int& height);
 
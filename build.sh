@@ -18,7 +18,9 @@ MINGW_BASE="/c/Users/Administrator/AppData/Local/Microsoft/WinGet/Packages/Brech
 # 源码列表 (对应 .vcxproj 中的 ClCompile 项)
 SOURCES=(
     biome.cpp
+    bitutils.cpp
     block.cpp
+    BlockRegistry.cpp
     blockstate.cpp
     chunk.cpp
     ChunkGenerator.cpp
@@ -39,12 +41,17 @@ SOURCES=(
     model.cpp
     ModelDeduplicator.cpp
     nbtutils.cpp
+    nbtview.cpp
     ObjExporter.cpp
     RegionCache.cpp
     RegionModelExporter.cpp
+    SectionMesher.cpp
+    SectionStore.cpp
+    SectionVolume.cpp
     SpecialBlock.cpp
     TaskMonitor.cpp
     texture.cpp
+    ThreadPool.cpp
 )
 
 # 拼接源码绝对路径